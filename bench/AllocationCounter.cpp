@@ -0,0 +1,113 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace
+{
+    std::atomic<size_t> n_allocations{0};
+    std::atomic<size_t> n_live_bytes{0};
+
+    void* track(void* pointer)
+    {
+        if (pointer == nullptr)
+        {
+            throw std::bad_alloc{};
+        }
+        n_allocations.fetch_add(1, std::memory_order_relaxed);
+        n_live_bytes.fetch_add(malloc_usable_size(pointer), std::memory_order_relaxed);
+        return pointer;
+    }
+
+    void* allocate(const std::size_t size)
+    {
+        return track(std::malloc(size == 0 ? 1 : size));
+    }
+
+    void* allocate(const std::size_t size, const std::align_val_t alignment)
+    {
+        const auto bytes{static_cast<std::size_t>(alignment)};
+        // aligned_alloc wants a whole number of alignments.
+        return track(std::aligned_alloc(bytes, (size + bytes - 1)/bytes*bytes));
+    }
+
+    void release(void* pointer)
+    {
+        if (pointer != nullptr)
+        {
+            n_live_bytes.fetch_sub(malloc_usable_size(pointer), std::memory_order_relaxed);
+            std::free(pointer);
+        }
+    }
+}
+
+size_t AllocationCounter::getCount()
+{
+    return n_allocations.load(std::memory_order_relaxed);
+}
+
+size_t AllocationCounter::getLiveBytes()
+{
+    return n_live_bytes.load(std::memory_order_relaxed);
+}
+
+void* operator new(const std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](const std::size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    release(pointer);
+}
+
+void operator delete(void* pointer, [[maybe_unused]] const std::size_t size) noexcept
+{
+    release(pointer);
+}
+
+void operator delete[](void* pointer, [[maybe_unused]] const std::size_t size) noexcept
+{
+    release(pointer);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    return allocate(size, alignment);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+    return allocate(size, alignment);
+}
+
+void operator delete(void* pointer, [[maybe_unused]] const std::align_val_t alignment) noexcept
+{
+    release(pointer);
+}
+
+void operator delete[](void* pointer, [[maybe_unused]] const std::align_val_t alignment) noexcept
+{
+    release(pointer);
+}
+
+void operator delete(void* pointer, [[maybe_unused]] const std::size_t size, [[maybe_unused]] const std::align_val_t alignment) noexcept
+{
+    release(pointer);
+}
+
+void operator delete[](void* pointer, [[maybe_unused]] const std::size_t size, [[maybe_unused]] const std::align_val_t alignment) noexcept
+{
+    release(pointer);
+}
@@ -0,0 +1,15 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+
+// Counts calls to the global operator new made anywhere in the benchmark process, and the heap
+// memory they currently hold.
+namespace AllocationCounter
+{
+    size_t getCount();
+    // Usable size of every live allocation, so allocator rounding is included but its bookkeeping is not.
+    size_t getLiveBytes();
+}
+
+#endif //ALLOCATIONCOUNTER_H
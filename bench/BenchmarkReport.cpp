@@ -0,0 +1,33 @@
+#include "BenchmarkReport.h"
+#include <iomanip>
+#include <iostream>
+
+void BenchmarkReport::add(const std::string& suite, const std::string& name, const int threads, const std::string& metric, const double value)
+{
+    results.push_back(BenchmarkResult{suite, name, threads, metric, value});
+    // Echo progress as results arrive, since a full run takes a while.
+    std::clog << suite << " " << name << " (" << threads << " threads) " << metric << ": " << value << "\n";
+}
+
+void BenchmarkReport::writeCSV(std::ostream& out) const
+{
+    out << "suite,name,threads,metric,value\n";
+    out << std::setprecision(9);
+    for (const BenchmarkResult& result : results)
+    {
+        out << result.suite << "," << result.name << "," << result.threads << "," << result.metric << "," << result.value << "\n";
+    }
+}
+
+void BenchmarkReport::writeJSON(std::ostream& out) const
+{
+    // Names are chosen by the benchmarks themselves and never need escaping.
+    out << "[\n" << std::setprecision(9);
+    for (size_t i{0}; i < results.size(); ++i)
+    {
+        const BenchmarkResult& result{results[i]};
+        out << "  {\"suite\": \"" << result.suite << "\", \"name\": \"" << result.name << "\", \"threads\": " << result.threads
+            << ", \"metric\": \"" << result.metric << "\", \"value\": " << result.value << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
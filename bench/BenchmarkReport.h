@@ -0,0 +1,32 @@
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One measurement. Threads is zero where the benchmark is inherently single threaded.
+struct BenchmarkResult
+{
+    std::string suite{};
+    std::string name{};
+    int threads{0};
+    std::string metric{};
+    double value{0.0};
+};
+
+// Collects results from every suite so they can be written in one machine-readable form,
+// either as CSV rows or as a JSON array of objects.
+class BenchmarkReport
+{
+public:
+    void add(const std::string& suite, const std::string& name, int threads, const std::string& metric, double value);
+
+    void writeCSV(std::ostream& out) const;
+    void writeJSON(std::ostream& out) const;
+
+private:
+    std::vector<BenchmarkResult> results{};
+};
+
+#endif //BENCHMARKREPORT_H
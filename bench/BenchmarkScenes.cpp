@@ -0,0 +1,214 @@
+#include "BenchmarkScenes.h"
+#include "Cuboid.h"
+#include "Sphere.h"
+#include "Utilities.h"
+#include <cmath>
+
+namespace
+{
+    CameraConfig makeConfig(const int image_width, const int anti_aliasing_samples, const double field_of_view)
+    {
+        CameraConfig config{};
+        config.aspect_ratio = 16.0/9.0;
+        config.image_width = image_width;
+        config.focus_distance = 10.0;
+        config.field_of_view = field_of_view;
+        config.anti_aliasing_samples = anti_aliasing_samples;
+        config.max_depth = 10;
+        config.seed = BenchmarkScenes::seed;
+        return config;
+    }
+
+    // Adds the small spheres of the book-one grid, or cubes of the same width in their place. Moving
+    // spheres rise at a random speed and fall back under gravity, so their swept bounds exercise the
+    // parabola turning points.
+    void addRandomGrid(Scene& scene, const bool moving, const bool cuboids = false)
+    {
+        Random::seedThreadGenerator(BenchmarkScenes::seed);
+        for (int a{-11}; a < 11; ++a)
+        {
+            for (int b{-11}; b < 11; ++b)
+            {
+                const double choose_material{Random::getRandom()};
+                const Vec3 centre{a + 0.9*Random::getRandom(), 0.2, b + 0.9*Random::getRandom()};
+                if ((centre - Vec3{4, 0.2, 0}).length() <= 0.9)
+                {
+                    continue;
+                }
+                const Newtonian dynamics{centre, Vec3{0.0, Random::getRandom(Interval{0.0, 1.0}), 0.0}, Vec3{0.0, -1.0, 0.0}};
+                const auto add_sphere{[&](const Material& material)
+                {
+                    if (cuboids)
+                    {
+                        scene.add(Cuboid{centre, Vec3{0.4, 0.4, 0.4}, material});
+                    }
+                    else if (moving)
+                    {
+                        scene.add(Sphere{centre, 0.2, material, dynamics});
+                    }
+                    else
+                    {
+                        scene.add(Sphere{centre, 0.2, material});
+                    }
+                }};
+                if (choose_material < 0.8)
+                {
+                    const Lambertian material{Vec3::getRandom()*Vec3::getRandom()};
+                    add_sphere(material);
+                }
+                else if (choose_material < 0.95)
+                {
+                    const Reflector material{Vec3::getRandom(Interval{0.5, 1.0}), Random::getRandom(Interval{0.0, 0.5})};
+                    add_sphere(material);
+                }
+                else
+                {
+                    const Refractor material{Vec3{1.0, 1.0, 1.0}, 1.5};
+                    add_sphere(material);
+                }
+            }
+        }
+        scene.add(Sphere{Vec3{0, -1000, 0}, 1000, Lambertian{Vec3{0.5, 0.5, 0.5}}});
+        scene.add(Sphere{Vec3{0, 1, 0}, 1.0, Refractor{Vec3{1.0, 1.0, 1.0}, 1.5}});
+        scene.add(Sphere{Vec3{-4, 1, 0}, 1.0, Lambertian{Vec3{0.4, 0.2, 0.1}}});
+        scene.add(Sphere{Vec3{4, 1, 0}, 1.0, Reflector{Vec3{0.7, 0.6, 0.5}, 0.0}});
+    }
+}
+
+BenchmarkScene BenchmarkScenes::makeRandomGrid(const int image_width)
+{
+    BenchmarkScene benchmark{"random_grid", Scene{1.0}, makeConfig(image_width, 15, 20), Vec3{13, 2, 3}, Vec3{0, 0, 0}};
+    benchmark.config.defocus_angle = 0.6;
+    addRandomGrid(benchmark.scene, false);
+    return benchmark;
+}
+
+BenchmarkScene BenchmarkScenes::makeCuboidGrid(const int image_width)
+{
+    BenchmarkScene benchmark{"cuboid_grid", Scene{1.0}, makeConfig(image_width, 15, 20), Vec3{13, 2, 3}, Vec3{0, 0, 0}};
+    addRandomGrid(benchmark.scene, false, true);
+    return benchmark;
+}
+
+BenchmarkScene BenchmarkScenes::makeGlassCuboids(const int image_width)
+{
+    BenchmarkScene benchmark{"glass_cuboids", Scene{1.0}, makeConfig(image_width, 31, 34), Vec3{13, 2, 3}, Vec3{0, 0, 0}};
+    const Lambertian lambertian{Vec3{0.4, 0.2, 0.1}};
+    const Reflector metal{Vec3{0.7, 0.6, 0.5}, 0.0};
+    const Refractor glass{Vec3{1.0, 1.0, 1.0}, 1.5};
+    benchmark.scene.add(Sphere{Vec3{0, -1000, 0}, 1000, Lambertian{Vec3{0.5, 0.5, 0.5}}});
+    benchmark.scene.add(Sphere{Vec3{6.0, 2.0, 3.0}, 2.0, metal});
+    benchmark.scene.add(Sphere{Vec3{0.0, 3.0, -5}, 3.0, metal});
+    benchmark.scene.add(Cuboid{Vec3{5, 0.2, -1}, {0.4, 0.4, 0.4}, glass});
+    benchmark.scene.add(Cuboid{Vec3{5, 0.2, -1}, {0.2, 0.2, 0.2}, lambertian});
+    benchmark.scene.add(Cuboid{Vec3{3, 0.5, 1}, {1.0, 1.0, 1.0}, glass});
+    return benchmark;
+}
+
+BenchmarkScene BenchmarkScenes::makeNewtonianMotion(const int image_width)
+{
+    BenchmarkScene benchmark{"newtonian_motion", Scene{1.0}, makeConfig(image_width, 15, 20), Vec3{13, 2, 3}, Vec3{0, 0, 0}, Interval{0.0, 0.5}};
+    addRandomGrid(benchmark.scene, true);
+    return benchmark;
+}
+
+BenchmarkScene BenchmarkScenes::makeSphereStress(const int image_width, const int n_spheres)
+{
+    BenchmarkScene benchmark{"sphere_stress_" + std::to_string(n_spheres), makeSphereCloud(n_spheres), makeConfig(image_width, 3, 60), Vec3{0, 0, 30}, Vec3{0, 0, 0}};
+    benchmark.config.max_depth = 4;
+    return benchmark;
+}
+
+BenchmarkScene BenchmarkScenes::makeOpenBox(const int image_width, const int max_depth)
+{
+    BenchmarkScene benchmark{"open_box", Scene{1.0}, makeConfig(image_width, 31, 70), Vec3{0, 3, 4.5}, Vec3{0, 1, 0}};
+    benchmark.config.max_depth = max_depth;
+    const Lambertian wall{Vec3{0.8, 0.8, 0.8}};
+    const Lambertian floor{Vec3{0.7, 0.5, 0.4}};
+    const Reflector metal{Vec3{0.8, 0.8, 0.8}, 0.1};
+    const Refractor glass{Vec3{1.0, 1.0, 1.0}, 1.5};
+    benchmark.scene.add(Cuboid{Vec3{0, -0.1, 0}, {10.4, 0.2, 10.4}, floor});
+    benchmark.scene.add(Cuboid{Vec3{-5.1, 3, 0}, {0.2, 6, 10.4}, wall});
+    benchmark.scene.add(Cuboid{Vec3{5.1, 3, 0}, {0.2, 6, 10.4}, wall});
+    benchmark.scene.add(Cuboid{Vec3{0, 3, -5.1}, {10.4, 6, 0.2}, wall});
+    benchmark.scene.add(Cuboid{Vec3{0, 3, 5.1}, {10.4, 6, 0.2}, wall});
+    // The ceiling leaves a two by two skylight in its middle.
+    benchmark.scene.add(Cuboid{Vec3{0, 6.1, -3}, {10.4, 0.2, 4}, wall});
+    benchmark.scene.add(Cuboid{Vec3{0, 6.1, 3}, {10.4, 0.2, 4}, wall});
+    benchmark.scene.add(Cuboid{Vec3{-3, 6.1, 0}, {4, 0.2, 2}, wall});
+    benchmark.scene.add(Cuboid{Vec3{3, 6.1, 0}, {4, 0.2, 2}, wall});
+    benchmark.scene.add(Sphere{Vec3{-1.5, 1, 0}, 1.0, glass});
+    benchmark.scene.add(Sphere{Vec3{1.5, 1, -1}, 1.0, metal});
+    benchmark.scene.add(Cuboid{Vec3{0.5, 0.5, 1.5}, {1.0, 1.0, 1.0}, glass});
+    return benchmark;
+}
+
+Scene BenchmarkScenes::makeSphereCloud(const int n_spheres)
+{
+    Random::seedThreadGenerator(seed);
+    const Lambertian material{Vec3{0.5, 0.5, 0.5}};
+    const Real half_width{10};
+    const double radius{half_width*0.5/std::cbrt(static_cast<double>(n_spheres))};
+    Scene scene{1.0};
+    for (int i{0}; i < n_spheres; ++i)
+    {
+        scene.add(Sphere{Vec3::getRandom(Interval{-half_width, half_width}), radius, material});
+    }
+    return scene;
+}
+
+Scene BenchmarkScenes::makeMaterialCloud(const int n_spheres)
+{
+    // Albedos come from a generator of their own, so the spheres sit exactly where the cloud's do.
+    Random::seedThreadGenerator(seed);
+    Random::Generator albedo_generator{seed, 1};
+    const Real half_width{10};
+    const double radius{half_width*0.5/std::cbrt(static_cast<double>(n_spheres))};
+    Scene scene{1.0};
+    for (int i{0}; i < n_spheres; ++i)
+    {
+        scene.add(Sphere{Vec3::getRandom(Interval{-half_width, half_width}), radius, Lambertian{Vec3::getRandom(albedo_generator, Interval{static_cast<Real>(0.3), static_cast<Real>(0.7)})}});
+    }
+    return scene;
+}
+
+Scene BenchmarkScenes::makeMovingCloud(const int n_spheres)
+{
+    Random::seedThreadGenerator(seed);
+    const Lambertian material{Vec3{0.5, 0.5, 0.5}};
+    const Real half_width{10};
+    const double radius{half_width*0.5/std::cbrt(static_cast<double>(n_spheres))};
+    Scene scene{1.0};
+    for (int i{0}; i < n_spheres; ++i)
+    {
+        const Vec3 centre{Vec3::getRandom(Interval{-half_width, half_width})};
+        const Newtonian dynamics{centre, Vec3::getRandom(Interval{-1, 1}), Vec3{0, -1, 0}};
+        scene.add(Sphere{centre, radius, material, dynamics});
+    }
+    return scene;
+}
+
+Scene BenchmarkScenes::makeCuboidCloud(const int n_cuboids)
+{
+    Random::seedThreadGenerator(seed);
+    const Lambertian material{Vec3{0.5, 0.5, 0.5}};
+    const Real half_width{10};
+    const double side{half_width*0.8/std::cbrt(static_cast<double>(n_cuboids))};
+    Scene scene{1.0};
+    for (int i{0}; i < n_cuboids; ++i)
+    {
+        scene.add(Cuboid{Vec3::getRandom(Interval{-half_width, half_width}), Vec3{side, side, side}, material});
+    }
+    return scene;
+}
+
+std::vector<BenchmarkScene> BenchmarkScenes::makeCanonicalScenes(const bool quick)
+{
+    const int image_width{quick ? 80 : 320};
+    std::vector<BenchmarkScene> scenes{};
+    scenes.push_back(makeRandomGrid(image_width));
+    scenes.push_back(makeGlassCuboids(image_width));
+    scenes.push_back(makeNewtonianMotion(image_width));
+    scenes.push_back(makeSphereStress(image_width, quick ? 10000 : 100000));
+    return scenes;
+}
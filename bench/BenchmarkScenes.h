@@ -0,0 +1,55 @@
+#ifndef BENCHMARKSCENES_H
+#define BENCHMARKSCENES_H
+
+#include "Camera.h"
+#include "Interval.h"
+#include "Scene.h"
+#include "Vec3.h"
+#include <string>
+#include <vector>
+
+// A scene together with the view and shutter interval it is rendered with. Scenes are built from
+// a fixed seed, so every run of the benchmark traces exactly the same rays.
+struct BenchmarkScene
+{
+    std::string name{};
+    Scene scene{1.0};
+    CameraConfig config{};
+    Vec3 origin{};
+    Vec3 look_at{};
+    Interval interval{DefinedIntervals::zero};
+};
+
+namespace BenchmarkScenes
+{
+    constexpr std::uint64_t seed{2024};
+
+    // The final scene of "Ray Tracing in One Weekend": a grid of small random spheres around three large ones.
+    BenchmarkScene makeRandomGrid(int image_width);
+    // The random grid with a cube in place of each small sphere, as the raytracer executable once built it.
+    BenchmarkScene makeCuboidGrid(int image_width);
+    // Nested glass and diffuse cuboids in front of mirrored spheres, as rendered by the raytracer executable.
+    BenchmarkScene makeGlassCuboids(int image_width);
+    // The random grid with every small sphere thrown upwards, rendered with motion blur.
+    BenchmarkScene makeNewtonianMotion(int image_width);
+    // A dense cloud of static spheres, dominated by traversal cost.
+    BenchmarkScene makeSphereStress(int image_width, int n_spheres);
+    // A pale diffuse room lit only through a skylight, with glass and mirrored spheres inside.
+    // Light reaches the camera only after many bounces, so paths run long.
+    BenchmarkScene makeOpenBox(int image_width, int max_depth);
+
+    // Fills a fixed volume with n spheres whose radii shrink with density, so the image stays
+    // comparable as n grows and only the cost of finding the closest hit changes.
+    Scene makeSphereCloud(int n_spheres);
+    // The sphere cloud with a material of its own for every sphere, as if each held a private copy.
+    Scene makeMaterialCloud(int n_spheres);
+    // The sphere cloud with every sphere drifting in a random direction, for motion blur.
+    Scene makeMovingCloud(int n_spheres);
+    // The same volume filled with n cubes instead.
+    Scene makeCuboidCloud(int n_cuboids);
+
+    // Smaller images in quick mode, for smoke-testing the benchmark itself.
+    std::vector<BenchmarkScene> makeCanonicalScenes(bool quick);
+}
+
+#endif //BENCHMARKSCENES_H
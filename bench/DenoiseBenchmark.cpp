@@ -0,0 +1,62 @@
+#include "DenoiseBenchmark.h"
+#include "BenchmarkScenes.h"
+#include "ImageReader.h"
+#include "PrecisionBenchmark.h"
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+namespace
+{
+    // Renders the scene to a PFM and reads it back, so the comparison sees the linear colours.
+    RenderStatistics renderPixels(BenchmarkScene& benchmark, const CameraConfig& config, const std::filesystem::path& image, std::vector<Vec3>& pixels)
+    {
+        Camera camera{config, benchmark.origin};
+        camera.lookAt(benchmark.look_at);
+        const RenderStatistics statistics{camera.render(benchmark.scene, image, benchmark.interval)};
+        int width{0};
+        int height{0};
+        ImageReader::readPFM(image, pixels, width, height);
+        return statistics;
+    }
+}
+
+void runDenoiseBenchmark(BenchmarkReport& report, const bool quick)
+{
+    const int image_width{quick ? 80 : 320};
+    const std::filesystem::path image{std::filesystem::temp_directory_path()/"raytracer_bench_denoise.pfm"};
+    std::vector<BenchmarkScene> benchmarks{};
+    benchmarks.push_back(BenchmarkScenes::makeGlassCuboids(image_width));
+    benchmarks.push_back(BenchmarkScenes::makeRandomGrid(image_width));
+    for (BenchmarkScene& benchmark : benchmarks)
+    {
+        CameraConfig config{benchmark.config};
+        config.image_format = ImageFormat::pfm;
+
+        CameraConfig reference_config{config};
+        reference_config.anti_aliasing_samples = (quick ? 256 : 1024) - 1;
+        reference_config.seed += 1;
+        std::vector<Vec3> reference{};
+        renderPixels(benchmark, reference_config, image, reference);
+
+        struct Mode
+        {
+            std::string name{};
+            int n_samples{};
+            bool denoise{};
+        };
+        for (const Mode& mode : {Mode{"51spp", 51, false}, Mode{"8spp", 8, false}, Mode{"8spp_denoised", 8, true}})
+        {
+            config.anti_aliasing_samples = mode.n_samples - 1;
+            config.denoise = mode.denoise;
+            std::vector<Vec3> pixels{};
+            const auto start{std::chrono::steady_clock::now()};
+            renderPixels(benchmark, config, image, pixels);
+            const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+            const std::string name{benchmark.name + "_" + mode.name};
+            report.add("denoise", name, config.threads, "total_seconds", elapsed.count());
+            report.add("denoise", name, config.threads, "rmse_8bit_vs_reference", getDisplayRMSE(pixels, reference));
+        }
+    }
+    std::filesystem::remove(image);
+}
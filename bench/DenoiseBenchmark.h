@@ -0,0 +1,11 @@
+#ifndef DENOISEBENCHMARK_H
+#define DENOISEBENCHMARK_H
+
+#include "BenchmarkReport.h"
+
+// Renders the canonical scenes at the raytracer executable's 51 samples per pixel and at 8 samples
+// with the denoiser, reporting the time each takes and its RMSE, in 8-bit display units, against a
+// render with many more samples and a different seed.
+void runDenoiseBenchmark(BenchmarkReport& report, bool quick);
+
+#endif //DENOISEBENCHMARK_H
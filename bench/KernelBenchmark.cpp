@@ -0,0 +1,97 @@
+#include "KernelBenchmark.h"
+#include "BenchmarkScenes.h"
+#include "Cuboid.h"
+#include "PackedPrimitives.h"
+#include "Sphere.h"
+#include "Utilities.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr int n_primitives{4096};
+    constexpr int n_rays{2000};
+    constexpr Interval ray_interval{Precision::ray_epsilon, Constants::infinity};
+
+    template <typename Function>
+    double getTestsPerSecond(Function&& test_ray, const std::vector<Ray>& rays)
+    {
+        int n_hits{0};
+        const auto start{std::chrono::steady_clock::now()};
+        for (const Ray& ray : rays)
+        {
+            n_hits += test_ray(ray) ? 1 : 0;
+        }
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        // Keeps the hit count observable so the loop cannot be optimised away.
+        if (n_hits < 0)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(rays.size())*n_primitives/elapsed.count();
+    }
+
+    template <typename Pack, typename Kernel>
+    void benchmarkPrimitive(BenchmarkReport& report, const char* name, const std::vector<std::unique_ptr<HittableEntity>>& entities,
+        const Pack& pack, Kernel (*get_kernel)(PackedKernels::InstructionSet), const std::vector<Ray>& rays)
+    {
+        report.add("kernel", std::string{name} + "_entity_loop", 0, "tests_per_second", getTestsPerSecond([&entities](const Ray& ray)
+        {
+            int n_hits{0};
+            for (const std::unique_ptr<HittableEntity>& entity : entities)
+            {
+                n_hits += entity->getRayHit(ray, ray_interval) ? 1 : 0;
+            }
+            return n_hits > 0;
+        }, rays));
+
+        for (const auto instruction_set : {PackedKernels::InstructionSet::scalar, PackedKernels::InstructionSet::avx2, PackedKernels::InstructionSet::avx512})
+        {
+            if (!PackedKernels::isSupported(instruction_set))
+            {
+                continue;
+            }
+            const Kernel kernel{get_kernel(instruction_set)};
+            const std::string method{std::string{name} + "_packed_" + PackedKernels::getName(instruction_set)};
+            report.add("kernel", method, 0, "tests_per_second", getTestsPerSecond([&pack, kernel](const Ray& ray)
+            {
+                return static_cast<bool>(kernel(pack, 0, pack.size(), PackedRay{ray}, PackedInterval{ray_interval.min, ray_interval.max}));
+            }, rays));
+        }
+    }
+}
+
+void runKernelBenchmark(BenchmarkReport& report)
+{
+    Random::seedThreadGenerator(BenchmarkScenes::seed);
+    const Lambertian material{Vec3{0.5, 0.5, 0.5}};
+    const Interval volume{-10.0, 10.0};
+
+    std::vector<Ray> rays{};
+    for (int i{0}; i < n_rays; ++i)
+    {
+        const Vec3 origin{Vec3::getRandom(Interval{-20.0, 20.0})};
+        rays.emplace_back(origin, Vec3::getRandom(volume) - origin, 1.0);
+    }
+
+    std::vector<std::unique_ptr<HittableEntity>> spheres{};
+    SpherePack sphere_pack{};
+    std::vector<std::unique_ptr<HittableEntity>> cuboids{};
+    CuboidPack cuboid_pack{};
+    for (int i{0}; i < n_primitives; ++i)
+    {
+        const Vec3 centre{Vec3::getRandom(volume)};
+        spheres.push_back(std::make_unique<Sphere>(centre, 0.1, material));
+        sphere_pack.add(centre, 0.1, static_cast<std::uint32_t>(i));
+        const Vec3 half_dimensions{0.1, 0.1, 0.1};
+        cuboids.push_back(std::make_unique<Cuboid>(centre, 2*half_dimensions, material));
+        cuboid_pack.add(centre - half_dimensions, centre + half_dimensions, static_cast<std::uint32_t>(i));
+    }
+    sphere_pack.pad();
+    cuboid_pack.pad();
+
+    benchmarkPrimitive(report, "sphere", spheres, sphere_pack, PackedKernels::getSphereKernel, rays);
+    benchmarkPrimitive(report, "cuboid", cuboids, cuboid_pack, PackedKernels::getCuboidKernel, rays);
+}
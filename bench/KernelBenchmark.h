@@ -0,0 +1,10 @@
+#ifndef KERNELBENCHMARK_H
+#define KERNELBENCHMARK_H
+
+#include "BenchmarkReport.h"
+
+// Reports ray-primitive tests per second, one entity at a time through the virtual getRayHit and
+// as packed ranges through each intersection kernel the CPU supports.
+void runKernelBenchmark(BenchmarkReport& report);
+
+#endif //KERNELBENCHMARK_H
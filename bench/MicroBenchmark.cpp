@@ -0,0 +1,251 @@
+#include "MicroBenchmark.h"
+#include "BenchmarkScenes.h"
+#include "Cuboid.h"
+#include "ImageWriter.h"
+#include "Material.h"
+#include "Sampler.h"
+#include "Sphere.h"
+#include "Utilities.h"
+#include <chrono>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr int n_inputs{1024};
+    constexpr int n_calls{4000000};
+    constexpr Interval ray_interval{Precision::ray_epsilon, Constants::infinity};
+
+    // Written once per benchmark so the compiler cannot discard the work being timed.
+    volatile double sink{0.0};
+
+    // Inputs cycle through a precomputed table, so no call can be hoisted out of the loop.
+    template <typename Function>
+    double getNanosecondsPerCall(const int n, Function&& call)
+    {
+        double checksum{0.0};
+        const auto start{std::chrono::steady_clock::now()};
+        for (int i{0}; i < n; ++i)
+        {
+            checksum += call(static_cast<size_t>(i % n_inputs));
+        }
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        sink = checksum;
+        return elapsed.count()*1e9/n;
+    }
+
+    void benchmarkIntersections(BenchmarkReport& report, const std::vector<Ray>& rays)
+    {
+        const Lambertian material{Vec3{0.5, 0.5, 0.5}};
+        const Sphere sphere{Vec3{0, 0, 0}, 1.0, material};
+        report.add("micro", "sphere_get_ray_hit", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            const Hit hit{sphere.getRayHit(rays[i], ray_interval)};
+            return hit ? hit.t : 0.0;
+        }));
+        const Cuboid cuboid{Vec3{0, 0, 0}, Vec3{1.5, 1.5, 1.5}, material};
+        report.add("micro", "cuboid_get_ray_hit", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            const Hit hit{cuboid.getRayHit(rays[i], ray_interval)};
+            return hit ? hit.t : 0.0;
+        }));
+    }
+
+    // Rays from the camera of a grid scene towards its floor, where the small primitives lie.
+    std::vector<Ray> getGridRays(const BenchmarkScene& benchmark)
+    {
+        Random::Generator generator{BenchmarkScenes::seed};
+        std::vector<Ray> rays{};
+        for (int i{0}; i < n_inputs; ++i)
+        {
+            const Vec3 target{Vec3::getRandom(generator, Interval{-11.0, 11.0})*Vec3{1, 0, 1} + Vec3{0, 0.2, 0}};
+            rays.emplace_back(benchmark.origin, target - benchmark.origin, 1.0);
+        }
+        return rays;
+    }
+
+    // Every ray tested against every primitive in turn, as a leaf of the hierarchy would. Most
+    // tests miss, as they do in a render. Reported per test.
+    template <typename Record, typename Function>
+    double getNanosecondsPerTest(const std::span<const Record> records, Function&& test)
+    {
+        const double ns_per_ray{getNanosecondsPerCall(n_calls/static_cast<int>(records.size()), [&](const size_t i)
+        {
+            double checksum{0.0};
+            for (const Record& record : records)
+            {
+                const Hit hit{test(record, i)};
+                checksum += hit ? hit.t : 0.0;
+            }
+            return checksum;
+        })};
+        return ns_per_ray/static_cast<double>(records.size());
+    }
+
+    // The spheres of the random grid and the cubes of the cuboid grid, each tested one by one and
+    // then traced through the whole scene.
+    void benchmarkGrids(BenchmarkReport& report)
+    {
+        BenchmarkScene sphere_grid{BenchmarkScenes::makeRandomGrid(320)};
+        sphere_grid.scene.setTimeInterval(sphere_grid.interval);
+        const std::vector<Ray> sphere_rays{getGridRays(sphere_grid)};
+        report.add("micro", "sphere_grid_get_ray_hit", 0, "ns_per_test", getNanosecondsPerTest(sphere_grid.scene.getSpheres(), [&](const SphereRecord& sphere, const size_t i)
+        {
+            return Sphere::getRayHit(sphere.centre, sphere.radius, sphere.material, sphere_rays[i], ray_interval);
+        }));
+        report.add("micro", "sphere_grid_closest_hit", 0, "ns_per_call", getNanosecondsPerCall(n_calls/8, [&](const size_t i)
+        {
+            const Hit hit{sphere_grid.scene.getClosestHit(sphere_rays[i], ray_interval)};
+            return hit ? hit.t : 0.0;
+        }));
+
+        BenchmarkScene cuboid_grid{BenchmarkScenes::makeCuboidGrid(320)};
+        cuboid_grid.scene.setTimeInterval(cuboid_grid.interval);
+        const std::vector<Ray> cuboid_rays{getGridRays(cuboid_grid)};
+        report.add("micro", "cuboid_grid_get_ray_hit", 0, "ns_per_test", getNanosecondsPerTest(cuboid_grid.scene.getCuboids(), [&](const CuboidRecord& cuboid, const size_t i)
+        {
+            return Cuboid::getRayHit(cuboid.centre, cuboid.half_dimensions, cuboid.material, cuboid_rays[i], ray_interval);
+        }));
+        report.add("micro", "cuboid_grid_closest_hit", 0, "ns_per_call", getNanosecondsPerCall(n_calls/8, [&](const size_t i)
+        {
+            const Hit hit{cuboid_grid.scene.getClosestHit(cuboid_rays[i], ray_interval)};
+            return hit ? hit.t : 0.0;
+        }));
+    }
+
+    void benchmarkVec3(BenchmarkReport& report, const std::vector<Vec3>& a, const std::vector<Vec3>& b)
+    {
+        report.add("micro", "vec3_dot", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            return a[i].dot(b[i]);
+        }));
+        report.add("micro", "vec3_cross", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            return a[i].cross(b[i])[0];
+        }));
+        report.add("micro", "vec3_normalise", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            return a[i].getNormalised()[1];
+        }));
+        report.add("micro", "vec3_multiply_add", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            return (a[i] + 0.5*b[i])[2];
+        }));
+    }
+
+    void benchmarkRandom(BenchmarkReport& report)
+    {
+        Random::Generator generator{BenchmarkScenes::seed};
+        report.add("micro", "random_next", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](size_t)
+        {
+            return static_cast<double>(generator.next());
+        }));
+        report.add("micro", "random_get_random", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](size_t)
+        {
+            return generator.getRandom();
+        }));
+        report.add("micro", "random_unit_vec3", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](size_t)
+        {
+            return Vec3::getRandomUnit(generator)[0];
+        }));
+        report.add("micro", "random_sample_generator", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            return static_cast<double>(Random::getSampleGenerator(BenchmarkScenes::seed, i, 1).next());
+        }));
+        // A fresh sample of its own pixel each call, as a render makes them, drawing its first
+        // bounce's direction.
+        for (const SamplerType type : {SamplerType::independent, SamplerType::stratified, SamplerType::sobol, SamplerType::blue_noise})
+        {
+            report.add("micro", std::string{"sampler_"} + Sampler::getName(type), 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+            {
+                Sampler sampler{type, BenchmarkScenes::seed, i/64, static_cast<int>(i/64 % 256), static_cast<int>(i/64/256), static_cast<int>(i % 64), 64};
+                sampler.startBounce(0);
+                return sampler.getUnitVector()[0];
+            }));
+        }
+    }
+
+    // Shades hits against a table mixing every kind of material, in the order a render meets them.
+    void benchmarkMaterials(BenchmarkReport& report, const std::vector<Ray>& rays, const std::vector<Vec3>& normals)
+    {
+        Random::Generator generator{BenchmarkScenes::seed};
+        Sampler sampler{SamplerType::independent, BenchmarkScenes::seed, 0, 0, 0, 0, 1};
+        std::vector<Material> materials{};
+        for (int i{0}; i < 64; ++i)
+        {
+            materials.push_back(Lambertian{Vec3::getRandom(generator)});
+            materials.push_back(Reflector{Vec3::getRandom(generator), generator.getRandom()});
+            materials.push_back(Refractor{Vec3{1, 1, 1}, 1.5});
+        }
+        std::vector<size_t> order(n_inputs);
+        for (size_t& index : order)
+        {
+            index = generator.next() % materials.size();
+        }
+        report.add("micro", "material_attenuate", 0, "ns_per_call", getNanosecondsPerCall(n_calls, [&](const size_t i)
+        {
+            Ray ray{rays[i]};
+            return Materials::attenuate(materials[order[i]], ray, Vec3{0, 0, 0}, normals[i], sampler)[0];
+        }));
+    }
+
+    // Encodes and writes a 1080p frame, reporting the cost per pixel of each output format.
+    void benchmarkImageWriter(BenchmarkReport& report)
+    {
+        constexpr int width{1920};
+        constexpr int height{1080};
+        constexpr int n_frames{5};
+        Random::Generator generator{BenchmarkScenes::seed};
+        std::vector<Vec3> pixels(static_cast<size_t>(width*height));
+        for (Vec3& pixel : pixels)
+        {
+            pixel = Vec3::getRandom(generator);
+        }
+        const std::filesystem::path output{std::filesystem::temp_directory_path()/"raytracer_bench_writer"};
+        const std::pair<ImageFormat, const char*> formats[]
+        {
+            {ImageFormat::ascii_ppm, "write_ascii_ppm"},
+            {ImageFormat::binary_ppm, "write_binary_ppm"},
+            {ImageFormat::pfm, "write_pfm"},
+        };
+        for (const auto& [format, name] : formats)
+        {
+            const auto encoder{ImageWriter::makeEncoder(format)};
+            const double ns_per_frame{getNanosecondsPerCall(n_frames, [&](size_t)
+            {
+                ImageWriter::write(output, pixels, width, height, *encoder);
+                return 0.0;
+            })};
+            report.add("micro", name, 0, "ns_per_pixel", ns_per_frame/(width*height));
+        }
+        std::filesystem::remove(output);
+    }
+}
+
+void runMicroBenchmark(BenchmarkReport& report)
+{
+    Random::Generator generator{BenchmarkScenes::seed};
+    std::vector<Ray> rays{};
+    std::vector<Vec3> a{};
+    std::vector<Vec3> b{};
+    std::vector<Vec3> normals{};
+    for (int i{0}; i < n_inputs; ++i)
+    {
+        // Aimed near the unit primitives at the origin, so roughly half the rays hit.
+        const Vec3 origin{Vec3::getRandom(generator, Interval{-5.0, 5.0}) + Vec3{0, 0, 10}};
+        rays.emplace_back(origin, Vec3::getRandom(generator, Interval{-2.0, 2.0}) - origin, 1.0);
+        a.push_back(Vec3::getRandom(generator, Interval{-1.0, 1.0}));
+        b.push_back(Vec3::getRandom(generator, Interval{-1.0, 1.0}));
+        // Facing the ray, as the normal of a surface it hits would.
+        normals.push_back(Vec3::getOnHemisphere(Vec3::getRandomUnit(generator), -rays.back().getDirection()));
+    }
+    benchmarkIntersections(report, rays);
+    benchmarkGrids(report);
+    benchmarkVec3(report, a, b);
+    benchmarkRandom(report);
+    benchmarkMaterials(report, rays, normals);
+    benchmarkImageWriter(report);
+}
@@ -0,0 +1,11 @@
+#ifndef MICROBENCHMARK_H
+#define MICROBENCHMARK_H
+
+#include "BenchmarkReport.h"
+
+// Times the building blocks of a sample in isolation: single-primitive intersection, tests against
+// grids of spheres and of cuboids, Vec3 arithmetic, the random number generator and image encoding.
+// Reported in nanoseconds per call.
+void runMicroBenchmark(BenchmarkReport& report);
+
+#endif //MICROBENCHMARK_H
@@ -0,0 +1,80 @@
+#include "PrecisionBenchmark.h"
+#include "BenchmarkScenes.h"
+#include "ImageReader.h"
+#include "Precision.h"
+#include <cmath>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    const std::string other_precision{std::string{Precision::name} == "double" ? "float" : "double"};
+}
+
+double getDisplayRMSE(const std::vector<Vec3>& a, const std::vector<Vec3>& b)
+{
+    double sum_squares{0.0};
+    for (size_t i{0}; i < a.size(); ++i)
+    {
+        for (int channel{0}; channel < 3; ++channel)
+        {
+            const double display_a{255.0*std::sqrt(std::max(static_cast<double>(a[i][channel]), 0.0))};
+            const double display_b{255.0*std::sqrt(std::max(static_cast<double>(b[i][channel]), 0.0))};
+            sum_squares += (display_a - display_b)*(display_a - display_b);
+        }
+    }
+    return std::sqrt(sum_squares/static_cast<double>(3*a.size()));
+}
+
+void runPrecisionBenchmark(BenchmarkReport& report, const std::filesystem::path& directory, const bool quick)
+{
+    std::filesystem::create_directories(directory);
+    for (BenchmarkScene& benchmark : BenchmarkScenes::makeCanonicalScenes(quick))
+    {
+        CameraConfig config{benchmark.config};
+        config.image_format = ImageFormat::pfm;
+        Camera camera{config, benchmark.origin};
+        camera.lookAt(benchmark.look_at);
+
+        const std::filesystem::path image{directory/(benchmark.name + "_" + Precision::name + ".pfm")};
+        const std::filesystem::path timing{directory/(benchmark.name + "_" + Precision::name + ".seconds")};
+        const RenderStatistics statistics{camera.render(benchmark.scene, image, benchmark.interval)};
+        std::ofstream{timing} << statistics.seconds << "\n";
+
+        const std::string name{benchmark.name + "_" + Precision::name};
+        report.add("precision", name, config.threads, "render_seconds", statistics.seconds);
+        report.add("precision", name, config.threads, "rays_per_second", static_cast<double>(statistics.n_rays)/statistics.seconds);
+
+        std::vector<Vec3> pixels{};
+        std::vector<Vec3> other_pixels{};
+        int width{0};
+        int height{0};
+        int other_width{0};
+        int other_height{0};
+        const std::filesystem::path other_image{directory/(benchmark.name + "_" + other_precision + ".pfm")};
+        if (!ImageReader::readPFM(image, pixels, width, height) || !ImageReader::readPFM(other_image, other_pixels, other_width, other_height)
+            || width != other_width || height != other_height)
+        {
+            continue;
+        }
+        report.add("precision", name, config.threads, "rmse_8bit_vs_" + other_precision, getDisplayRMSE(pixels, other_pixels));
+
+        // Sampling noise alone separates two renders with different seeds; differences from the
+        // other precision are only significant beyond this.
+        config.seed += 1;
+        camera.updateConfig(config);
+        const std::filesystem::path reseeded_image{directory/(benchmark.name + "_reseeded.pfm")};
+        camera.render(benchmark.scene, reseeded_image, benchmark.interval);
+        std::vector<Vec3> reseeded_pixels{};
+        if (ImageReader::readPFM(reseeded_image, reseeded_pixels, width, height))
+        {
+            report.add("precision", name, config.threads, "rmse_8bit_noise_floor", getDisplayRMSE(pixels, reseeded_pixels));
+        }
+        std::filesystem::remove(reseeded_image);
+        double other_seconds{0.0};
+        if (std::ifstream{directory/(benchmark.name + "_" + other_precision + ".seconds")} >> other_seconds)
+        {
+            report.add("precision", name, config.threads, "speedup_vs_" + other_precision, other_seconds/statistics.seconds);
+        }
+    }
+}
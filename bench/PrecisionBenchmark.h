@@ -0,0 +1,18 @@
+#ifndef PRECISIONBENCHMARK_H
+#define PRECISIONBENCHMARK_H
+
+#include "BenchmarkReport.h"
+#include "Vec3.h"
+#include <filesystem>
+#include <vector>
+
+// Renders the canonical scenes in this build's precision and keeps each image, as a PFM, in the
+// given directory. Once the other precision's build has left its images there too, also reports
+// the RMSE between the two in 8-bit display units and this build's speedup over the other. The
+// RMSE between two seeds of the same render is reported alongside, as the noise floor.
+void runPrecisionBenchmark(BenchmarkReport& report, const std::filesystem::path& directory, bool quick);
+
+// Compares images as they would be displayed: gamma corrected and scaled to 8 bits.
+double getDisplayRMSE(const std::vector<Vec3>& a, const std::vector<Vec3>& b);
+
+#endif //PRECISIONBENCHMARK_H
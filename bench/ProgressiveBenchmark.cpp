@@ -0,0 +1,63 @@
+#include "ProgressiveBenchmark.h"
+#include "BenchmarkScenes.h"
+#include <chrono>
+#include <string>
+
+namespace
+{
+    struct ProgressiveResult
+    {
+        double first_image_seconds{0.0};
+        ProgressivePass last_pass{};
+        RenderStatistics statistics{};
+        double samples_per_pixel{0.0};
+    };
+
+    // Times are taken around the render call, so they include handing each pass to the caller.
+    ProgressiveResult renderProgressive(BenchmarkScene& benchmark, const CameraConfig& config)
+    {
+        Camera camera{config, benchmark.origin};
+        camera.lookAt(benchmark.look_at);
+        ProgressiveResult result{};
+        Framebuffer framebuffer{camera.getImageWidth(), camera.getImageHeight()};
+        RenderCallbacks callbacks{};
+        const auto start{std::chrono::steady_clock::now()};
+        callbacks.pass_completed = [&](const FramebufferView&, const ProgressivePass& pass)
+        {
+            if (pass.pass == 0)
+            {
+                result.first_image_seconds = std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
+            }
+            result.last_pass = pass;
+        };
+        result.statistics = camera.render(benchmark.scene, framebuffer.getView(), benchmark.interval, callbacks);
+        result.samples_per_pixel = static_cast<double>(result.statistics.n_samples)/(camera.getImageWidth()*camera.getImageHeight());
+        return result;
+    }
+}
+
+void runProgressiveBenchmark(BenchmarkReport& report, const bool quick)
+{
+    BenchmarkScene benchmark{BenchmarkScenes::makeGlassCuboids(quick ? 320 : 1920)};
+    CameraConfig config{benchmark.config};
+    config.anti_aliasing_samples = 50;
+    config.progressive = true;
+
+    config.time_budget = quick ? 0.5 : 2.0;
+    const ProgressiveResult budgeted{renderProgressive(benchmark, config)};
+    const std::string name{benchmark.name + "_" + std::to_string(config.image_width) + "px"};
+    report.add("progressive", name, config.threads, "first_image_seconds", budgeted.first_image_seconds);
+    report.add("progressive", name, config.threads, "total_seconds", budgeted.statistics.seconds);
+    report.add("progressive", name, config.threads, "passes", budgeted.last_pass.pass);
+    report.add("progressive", name, config.threads, "samples_per_pixel", budgeted.samples_per_pixel);
+
+    // Small enough that the noise target, not the deadline, ends the render.
+    config.image_width = quick ? 80 : 320;
+    config.time_budget = 0.0;
+    config.target_noise = 0.02;
+    const ProgressiveResult targeted{renderProgressive(benchmark, config)};
+    const std::string target_name{benchmark.name + "_" + std::to_string(config.image_width) + "px_target_noise"};
+    report.add("progressive", target_name, config.threads, "total_seconds", targeted.statistics.seconds);
+    report.add("progressive", target_name, config.threads, "passes", targeted.last_pass.pass);
+    report.add("progressive", target_name, config.threads, "noise", targeted.last_pass.noise);
+}
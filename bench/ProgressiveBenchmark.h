@@ -0,0 +1,11 @@
+#ifndef PROGRESSIVEBENCHMARK_H
+#define PROGRESSIVEBENCHMARK_H
+
+#include "BenchmarkReport.h"
+
+// Renders the raytracer executable's scene progressively into memory, reporting how long the first
+// image takes to arrive and how far the render gets in its time budget, then renders it again until
+// a target noise level, reporting how long that takes.
+void runProgressiveBenchmark(BenchmarkReport& report, bool quick);
+
+#endif //PROGRESSIVEBENCHMARK_H
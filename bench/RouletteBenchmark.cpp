@@ -0,0 +1,61 @@
+#include "RouletteBenchmark.h"
+#include "BenchmarkScenes.h"
+#include "ImageReader.h"
+#include "PrecisionBenchmark.h"
+#include <filesystem>
+#include <string>
+
+namespace
+{
+    // Renders the scene to a PFM and reads it back, so the comparison sees the linear colours.
+    RenderStatistics renderPixels(BenchmarkScene& benchmark, const CameraConfig& config, const std::filesystem::path& image, std::vector<Vec3>& pixels)
+    {
+        Camera camera{config, benchmark.origin};
+        camera.lookAt(benchmark.look_at);
+        const RenderStatistics statistics{camera.render(benchmark.scene, image, benchmark.interval)};
+        int width{0};
+        int height{0};
+        ImageReader::readPFM(image, pixels, width, height);
+        return statistics;
+    }
+}
+
+void runRouletteBenchmark(BenchmarkReport& report, const bool quick)
+{
+    const int image_width{quick ? 80 : 320};
+    // Deep enough for light to find its way through nested glass, which a fixed budget pays for on every path.
+    constexpr int max_depth{50};
+    const std::filesystem::path image{std::filesystem::temp_directory_path()/"raytracer_bench_roulette.pfm"};
+    std::vector<BenchmarkScene> benchmarks{};
+    benchmarks.push_back(BenchmarkScenes::makeOpenBox(image_width, max_depth));
+    benchmarks.push_back(BenchmarkScenes::makeGlassCuboids(image_width));
+    for (BenchmarkScene& benchmark : benchmarks)
+    {
+        CameraConfig config{benchmark.config};
+        config.image_format = ImageFormat::pfm;
+        config.max_depth = max_depth;
+
+        CameraConfig reference_config{config};
+        reference_config.anti_aliasing_samples = 4*(config.anti_aliasing_samples + 1) - 1;
+        reference_config.seed += 1;
+        std::vector<Vec3> reference{};
+        renderPixels(benchmark, reference_config, image, reference);
+
+        for (const bool russian_roulette : {false, true})
+        {
+            config.russian_roulette = russian_roulette;
+            std::vector<Vec3> pixels{};
+            const RenderStatistics statistics{renderPixels(benchmark, config, image, pixels)};
+            const std::string name{benchmark.name + (russian_roulette ? "_roulette" : "_fixed_depth")};
+            report.add("roulette", name, config.threads, "render_seconds", statistics.seconds);
+            report.add("roulette", name, config.threads, "rays_per_sample", static_cast<double>(statistics.n_rays)/static_cast<double>(statistics.n_samples));
+            report.add("roulette", name, config.threads, "rays_per_second", static_cast<double>(statistics.n_rays)/statistics.seconds);
+            const double rmse{getDisplayRMSE(pixels, reference)};
+            report.add("roulette", name, config.threads, "rmse_8bit_vs_reference", rmse);
+            // Error falls as one over the square root of the samples, so this product is what an
+            // equal-quality comparison turns on: lower means less time to reach the same error.
+            report.add("roulette", name, config.threads, "rmse_squared_seconds", rmse*rmse*statistics.seconds);
+        }
+    }
+    std::filesystem::remove(image);
+}
@@ -0,0 +1,11 @@
+#ifndef ROULETTEBENCHMARK_H
+#define ROULETTEBENCHMARK_H
+
+#include "BenchmarkReport.h"
+
+// Renders scenes with long paths at a fixed depth and with Russian roulette, reporting each mode's
+// ray throughput and its RMSE, in 8-bit display units, against a fixed-depth render with four
+// times the samples and a different seed.
+void runRouletteBenchmark(BenchmarkReport& report, bool quick);
+
+#endif //ROULETTEBENCHMARK_H
@@ -0,0 +1,66 @@
+#include "SamplingBenchmark.h"
+#include "BenchmarkScenes.h"
+#include "ImageReader.h"
+#include "PrecisionBenchmark.h"
+#include "Sampler.h"
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace
+{
+    // Renders the scene to a PFM and reads it back, so the comparison sees the linear colours.
+    RenderStatistics renderPixels(BenchmarkScene& benchmark, const CameraConfig& config, const std::filesystem::path& image, std::vector<Vec3>& pixels)
+    {
+        Camera camera{config, benchmark.origin};
+        camera.lookAt(benchmark.look_at);
+        const RenderStatistics statistics{camera.render(benchmark.scene, image, benchmark.interval)};
+        int width{0};
+        int height{0};
+        ImageReader::readPFM(image, pixels, width, height);
+        return statistics;
+    }
+}
+
+void runSamplingBenchmark(BenchmarkReport& report, const bool quick)
+{
+    const int image_width{quick ? 64 : 160};
+    const std::filesystem::path image{std::filesystem::temp_directory_path()/"raytracer_bench_sampling.pfm"};
+    BenchmarkScene benchmark{BenchmarkScenes::makeGlassCuboids(image_width)};
+    CameraConfig config{benchmark.config};
+    config.image_format = ImageFormat::pfm;
+    // A little defocus, so the lens dimensions have something to resolve.
+    config.defocus_angle = 0.6;
+
+    CameraConfig reference_config{config};
+    reference_config.anti_aliasing_samples = (quick ? 256 : 2048) - 1;
+    reference_config.seed += 1;
+    std::vector<Vec3> reference{};
+    renderPixels(benchmark, reference_config, image, reference);
+
+    constexpr int most_samples{64};
+    std::map<SamplerType, double> final_rmse{};
+    for (const SamplerType sampler : {SamplerType::independent, SamplerType::stratified, SamplerType::sobol, SamplerType::blue_noise})
+    {
+        config.sampler = sampler;
+        for (int n_samples{4}; n_samples <= most_samples; n_samples *= 2)
+        {
+            config.anti_aliasing_samples = n_samples - 1;
+            std::vector<Vec3> pixels{};
+            const RenderStatistics statistics{renderPixels(benchmark, config, image, pixels)};
+            const std::string name{benchmark.name + "_" + Sampler::getName(sampler) + "_" + std::to_string(n_samples) + "spp"};
+            const double rmse{getDisplayRMSE(pixels, reference)};
+            report.add("sampling", name, config.threads, "render_seconds", statistics.seconds);
+            report.add("sampling", name, config.threads, "rmse_8bit_vs_reference", rmse);
+            final_rmse[sampler] = rmse;
+        }
+    }
+    // Independent error falls as one over the square root of the samples, so matching a sampler's
+    // error would take this many times the independent samples.
+    for (const auto& [sampler, rmse] : final_rmse)
+    {
+        const double ratio{final_rmse[SamplerType::independent]/rmse};
+        report.add("sampling", benchmark.name + "_" + Sampler::getName(sampler) + "_" + std::to_string(most_samples) + "spp", config.threads, "equivalent_independent_samples", most_samples*ratio*ratio);
+    }
+    std::filesystem::remove(image);
+}
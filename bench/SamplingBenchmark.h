@@ -0,0 +1,11 @@
+#ifndef SAMPLINGBENCHMARK_H
+#define SAMPLINGBENCHMARK_H
+
+#include "BenchmarkReport.h"
+
+// Renders the raytracer executable's scene with each sampler at a range of sample counts, reporting
+// the RMSE, in 8-bit display units, against an independent render with many more samples and a
+// different seed, and how many independent samples each sampler's 64 are worth.
+void runSamplingBenchmark(BenchmarkReport& report, bool quick);
+
+#endif //SAMPLINGBENCHMARK_H
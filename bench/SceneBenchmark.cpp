@@ -0,0 +1,46 @@
+#include "SceneBenchmark.h"
+#include "BenchmarkScenes.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+namespace
+{
+    // Doubles from one thread, always ending on the full hardware count.
+    std::vector<int> getThreadCounts()
+    {
+        const int n_hardware_threads{std::max(static_cast<int>(std::thread::hardware_concurrency()), 1)};
+        std::vector<int> thread_counts{};
+        for (int n_threads{1}; n_threads < n_hardware_threads; n_threads *= 2)
+        {
+            thread_counts.push_back(n_threads);
+        }
+        thread_counts.push_back(n_hardware_threads);
+        return thread_counts;
+    }
+}
+
+void runSceneBenchmark(BenchmarkReport& report, const bool quick)
+{
+    const std::filesystem::path output{std::filesystem::temp_directory_path()/"raytracer_bench_scene.ppm"};
+    for (BenchmarkScene& benchmark : BenchmarkScenes::makeCanonicalScenes(quick))
+    {
+        for (const int n_threads : getThreadCounts())
+        {
+            CameraConfig config{benchmark.config};
+            config.threads = n_threads;
+            Camera camera{config, benchmark.origin};
+            camera.lookAt(benchmark.look_at);
+
+            // Wall time covers the whole render call, including the scene build and image write.
+            const auto start{std::chrono::steady_clock::now()};
+            const RenderStatistics statistics{camera.render(benchmark.scene, output, benchmark.interval)};
+            const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+
+            report.add("scene", benchmark.name, n_threads, "wall_seconds", elapsed.count());
+            report.add("scene", benchmark.name, n_threads, "samples_per_second", static_cast<double>(statistics.n_samples)/statistics.seconds);
+            report.add("scene", benchmark.name, n_threads, "rays_per_second", static_cast<double>(statistics.n_rays)/statistics.seconds);
+        }
+    }
+    std::filesystem::remove(output);
+}
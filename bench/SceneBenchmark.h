@@ -0,0 +1,10 @@
+#ifndef SCENEBENCHMARK_H
+#define SCENEBENCHMARK_H
+
+#include "BenchmarkReport.h"
+
+// Renders each canonical scene end to end at every thread count up to the hardware's, reporting
+// wall time and sample and ray throughput.
+void runSceneBenchmark(BenchmarkReport& report, bool quick);
+
+#endif //SCENEBENCHMARK_H
@@ -0,0 +1,369 @@
+#include "AllocationCounter.h"
+#include "BenchmarkReport.h"
+#include "BenchmarkScenes.h"
+#include "Camera.h"
+#include "Cuboid.h"
+#include "DenoiseBenchmark.h"
+#include "KernelBenchmark.h"
+#include "MicroBenchmark.h"
+#include "PrecisionBenchmark.h"
+#include "ProgressiveBenchmark.h"
+#include "RouletteBenchmark.h"
+#include "SamplingBenchmark.h"
+#include "Scene.h"
+#include "SceneFile.h"
+#include "SceneBenchmark.h"
+#include "Sphere.h"
+#include "Utilities.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+
+namespace
+{
+    // Times closest-hit queries alone, isolating traversal from the rest of the per-sample work.
+    // Rays are traced at times drawn through the interval, from a generator of their own so the
+    // directions are the same whatever the interval.
+    double timeClosestHits(Scene& scene, const Vec3& origin, const int n_rays, const Interval& interval = DefinedIntervals::zero)
+    {
+        scene.setTimeInterval(interval);
+        Random::Generator generator{BenchmarkScenes::seed};
+        Random::Generator time_generator{BenchmarkScenes::seed, 1};
+        int n_hits{0};
+        const auto start{std::chrono::steady_clock::now()};
+        for (int i{0}; i < n_rays; ++i)
+        {
+            const Vec3 direction{Vec3::getRandom(generator, Interval{-10.0, 10.0}) - origin};
+            const Ray ray{origin, direction, scene.getRefractiveIndex(), scene.sampleTime(time_generator)};
+            if (scene.getClosestHit(ray, DefinedIntervals::visible_universe))
+            {
+                ++n_hits;
+            }
+        }
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        std::clog << "Hit " << n_hits << " of " << n_rays << " rays.\n";
+        return elapsed.count();
+    }
+
+    // Checks that closest-hit queries grow logarithmically with the number of entities.
+    void runScalingBenchmark(BenchmarkReport& report, const std::filesystem::path& output)
+    {
+        constexpr CameraConfig camera_config
+        {
+            .aspect_ratio = 16.0/9.0,
+            .image_width = 160,
+            .focus_distance = 10.0,
+            .field_of_view = 60,
+            .defocus_angle = 0.0,
+            .framerate = 1,
+            .anti_aliasing_samples = 4,
+            .max_depth = 4,
+        };
+        Camera camera{camera_config, Vec3{0, 0, 30}};
+        camera.lookAt(Vec3{0, 0, 0});
+
+        constexpr int n_rays{200000};
+        for (const int n_spheres : {16, 128, 1024, 8192, 65536})
+        {
+            Scene scene{BenchmarkScenes::makeSphereCloud(n_spheres)};
+            const std::string name{"sphere_cloud_" + std::to_string(n_spheres)};
+            report.add("scaling", name, 0, "render_seconds", camera.render(scene, output, 0.0).seconds);
+            const double query_ns{timeClosestHits(scene, Vec3{0, 0, 30}, n_rays)*1e9/n_rays};
+            report.add("scaling", name, 0, "closest_hit_ns", query_ns);
+            report.add("scaling", name, 0, "closest_hit_ns_per_log2_entities", query_ns/std::log2(n_spheres));
+        }
+    }
+
+    // Measures the heap memory a scene holds per primitive, once added and once its hierarchies are
+    // built, and the closest-hit cost at a size where the storage no longer fits in cache.
+    void runStorageBenchmark(BenchmarkReport& report, const bool quick)
+    {
+        const int n_primitives{quick ? 100000 : 1000000};
+        const auto measure{[&report, n_primitives](const std::string& name, const auto& make_scene)
+        {
+            const size_t before{AllocationCounter::getLiveBytes()};
+            Scene scene{make_scene(n_primitives)};
+            const size_t stored{AllocationCounter::getLiveBytes() - before};
+            const auto start{std::chrono::steady_clock::now()};
+            scene.setTimeInterval(DefinedIntervals::zero);
+            const std::chrono::duration<double> build_seconds{std::chrono::steady_clock::now() - start};
+            const size_t built{AllocationCounter::getLiveBytes() - before};
+
+            const double n{static_cast<double>(n_primitives)};
+            report.add("storage", name, 0, "stored_bytes_per_primitive", static_cast<double>(stored)/n);
+            report.add("storage", name, 0, "built_bytes_per_primitive", static_cast<double>(built)/n);
+            report.add("storage", name, 0, "build_seconds", build_seconds.count());
+            constexpr int n_rays{200000};
+            report.add("storage", name, 0, "closest_hit_ns", timeClosestHits(scene, Vec3{0, 0, 30}, n_rays)*1e9/n_rays);
+        }};
+        measure("sphere_cloud_" + std::to_string(n_primitives), BenchmarkScenes::makeSphereCloud);
+        measure("cuboid_cloud_" + std::to_string(n_primitives), BenchmarkScenes::makeCuboidCloud);
+    }
+
+    // Compares a cloud of spheres sharing one material with the same cloud giving every sphere its
+    // own, reporting the memory each library takes and how the larger working set slows shading.
+    void runMaterialBenchmark(BenchmarkReport& report, const std::filesystem::path& output, const bool quick)
+    {
+        const int n_spheres{quick ? 100000 : 1000000};
+        constexpr int n_rays{200000};
+        CameraConfig config{.image_width = 160, .field_of_view = 60, .anti_aliasing_samples = 8, .max_depth = 4};
+        Camera camera{config, Vec3{0, 0, 30}};
+        camera.lookAt(Vec3{0, 0, 0});
+        const auto measure{[&](const std::string& name, Scene scene)
+        {
+            const MaterialReport materials{scene.getMaterialReport()};
+            report.add("materials", name, 0, "unique_materials", static_cast<double>(materials.n_unique));
+            report.add("materials", name, 0, "material_references", static_cast<double>(materials.n_references));
+            report.add("materials", name, 0, "library_bytes", static_cast<double>(materials.library_bytes));
+            report.add("materials", name, 0, "copied_bytes", static_cast<double>(materials.copied_bytes));
+            report.add("materials", name, 0, "render_seconds", camera.render(scene, output, 0.0).seconds);
+            report.add("materials", name, 0, "closest_hit_ns", timeClosestHits(scene, Vec3{0, 0, 30}, n_rays)*1e9/n_rays);
+        }};
+        measure("shared_" + std::to_string(n_spheres), BenchmarkScenes::makeSphereCloud(n_spheres));
+        measure("distinct_" + std::to_string(n_spheres), BenchmarkScenes::makeMaterialCloud(n_spheres));
+    }
+
+    // Times getting a scene of spheres into memory: adding each through Scene::add, parsing its
+    // text scene file, and mapping its compiled cache.
+    void runLoadingBenchmark(BenchmarkReport& report, const bool quick)
+    {
+        const int n_spheres{quick ? 100000 : 1000000};
+        const std::string name{"sphere_cloud_" + std::to_string(n_spheres)};
+        const auto time{[](const auto& load)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            load();
+            return std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
+        }};
+
+        SceneDescription description{};
+        report.add("loading", name, 0, "add_seconds", time([&]
+        {
+            description.scene = BenchmarkScenes::makeSphereCloud(n_spheres);
+        }));
+
+        const std::filesystem::path text_path{std::filesystem::temp_directory_path()/"raytracer_bench_loading.scene"};
+        const std::filesystem::path cache_path{std::filesystem::temp_directory_path()/"raytracer_bench_loading.rtsc"};
+        {
+            std::ofstream text{text_path};
+            text << "material grey lambertian 0.5 0.5 0.5\n";
+            for (const SphereRecord& sphere : description.scene.getSpheres())
+            {
+                text << "sphere " << sphere.centre[0] << " " << sphere.centre[1] << " " << sphere.centre[2] << " " << sphere.radius << " grey\n";
+            }
+        }
+        SceneFile::writeCache(cache_path, description);
+
+        SceneDescription text_description{};
+        report.add("loading", name, 0, "text_seconds", time([&]
+        {
+            SceneFile::readText(text_path, text_description);
+        }));
+        SceneDescription cache_description{};
+        report.add("loading", name, 0, "cache_seconds", time([&]
+        {
+            SceneFile::readCache(cache_path, cache_description);
+        }));
+        std::clog << "Loaded " << text_description.scene.size() << " spheres from text and " << cache_description.scene.size() << " from the cache.\n";
+        std::filesystem::remove(text_path);
+        std::filesystem::remove(cache_path);
+    }
+
+    // Compares closest-hit queries and a render with motion blur over moving spheres, with positions
+    // evaluated exactly and snapshotted into time slices, against the same spheres standing still.
+    void runMotionBenchmark(BenchmarkReport& report, const std::filesystem::path& output)
+    {
+        constexpr int n_spheres{10000};
+        constexpr int n_rays{200000};
+        const Interval shutter{0, 1};
+        CameraConfig config{.image_width = 160, .field_of_view = 60, .anti_aliasing_samples = 8, .max_depth = 4};
+        Camera camera{config, Vec3{0, 0, 30}};
+        camera.lookAt(Vec3{0, 0, 0});
+        const auto measure{[&](const std::string& name, Scene& scene)
+        {
+            report.add("motion", name, 0, "render_seconds", camera.render(scene, output, shutter).seconds);
+            report.add("motion", name, 0, "closest_hit_ns", timeClosestHits(scene, Vec3{0, 0, 30}, n_rays, shutter)*1e9/n_rays);
+        }};
+
+        Scene moving{BenchmarkScenes::makeMovingCloud(n_spheres)};
+        measure("moving_cloud_" + std::to_string(n_spheres), moving);
+        constexpr int n_time_slices{16};
+        moving.setTimeSlices(n_time_slices);
+        measure("moving_cloud_" + std::to_string(n_spheres) + "_slices_" + std::to_string(n_time_slices), moving);
+        Scene still{BenchmarkScenes::makeSphereCloud(n_spheres)};
+        measure("static_cloud_" + std::to_string(n_spheres), still);
+    }
+
+    // Counts the allocations made by one render, after a first has made any one-off lazy
+    // allocations (thread pools, stream buffers).
+    size_t countRenderAllocations(Scene& scene, const CameraConfig& config, const Vec3& origin, const std::filesystem::path& output)
+    {
+        Camera camera{config, origin};
+        camera.lookAt(Vec3{0, 0, 0});
+        camera.render(scene, output, 0.0);
+        const size_t before{AllocationCounter::getCount()};
+        camera.render(scene, output, 0.0);
+        return AllocationCounter::getCount() - before;
+    }
+
+    // Checks that rendering allocates nothing per sample or per pixel, returning false if it does.
+    // Renders at two sample counts differ only in their samples, and renders at two sizes only in
+    // their pixels, so any allocation made once per render cancels out of both differences.
+    bool runAllocationBenchmark(BenchmarkReport& report, const std::filesystem::path& output)
+    {
+        Scene scene{1.0};
+        scene.add(Sphere{Vec3{0, -1000, 0}, 1000, Lambertian{Vec3{0.5, 0.5, 0.5}}});
+        scene.add(Sphere{Vec3{-2, 1, 0}, 1, Reflector{Vec3{0.7, 0.6, 0.5}, 0.3}});
+        scene.add(Sphere{Vec3{0, 1, 0}, 1, Refractor{Vec3{1, 1, 1}, 1.5}});
+        scene.add(Cuboid{Vec3{2, 1, 0}, Vec3{1, 1, 1}, Refractor{Vec3{1, 1, 1}, 1.5}});
+        const Vec3 origin{0, 2, 8};
+
+        constexpr int extra_samples{8};
+        // A fixed thread count, no more than the smaller image has tiles, so both sizes start as many threads.
+        CameraConfig config{.image_width = 32, .field_of_view = 60, .anti_aliasing_samples = 0, .max_depth = 8, .threads = 2};
+        const auto get_n_pixels{[&config]
+        {
+            return config.image_width*std::max(static_cast<int>(config.image_width/config.aspect_ratio), 1);
+        }};
+        const int n_small_pixels{get_n_pixels()};
+        const size_t small{countRenderAllocations(scene, config, origin, output)};
+        config.image_width = 64;
+        const int n_pixels{get_n_pixels()};
+        const size_t low{countRenderAllocations(scene, config, origin, output)};
+        config.anti_aliasing_samples = extra_samples;
+        const size_t high{countRenderAllocations(scene, config, origin, output)};
+
+        const auto get_rate{[](const size_t more, const size_t fewer, const int n)
+        {
+            return (static_cast<double>(more) - static_cast<double>(fewer))/n;
+        }};
+        const double per_sample{get_rate(high, low, extra_samples*n_pixels)};
+        const double per_pixel{get_rate(low, small, n_pixels - n_small_pixels)};
+        report.add("allocation", "mixed_scene", 0, "allocations_per_sample", per_sample);
+        report.add("allocation", "mixed_scene", 0, "allocations_per_pixel", per_pixel);
+        std::clog << "Renders allocated " << small << " times at " << n_small_pixels << " pixels, " << low << " at " << n_pixels
+                  << " and " << high << " at " << n_pixels << " with " << extra_samples << " more samples each.\n";
+        if (high != low || low != small)
+        {
+            std::clog << "Rendering should never allocate per sample or per pixel, but made " << per_sample << " allocations per sample and "
+                      << per_pixel << " per pixel.\n";
+            return false;
+        }
+        return true;
+    }
+}
+
+// Usage: raytracer_bench [--json] [--quick] [--image-dir DIRECTORY] [suite...]
+// Suites are scene, micro, kernel, scaling, allocation, storage, materials, loading, motion,
+// roulette, sampling, denoise, progressive and precision; all of them run when none are named. The
+// precision suite keeps its images in the image directory, a temporary one by default, so the
+// float build of the benchmark can compare against them. Results go to stdout as CSV, or as JSON
+// with --json, and progress goes to stderr. Exits with 1 if a suite's check fails, as the
+// allocation suite's does when rendering allocates per sample or per pixel.
+int main(const int argc, char** argv)
+{
+    bool json{false};
+    bool quick{false};
+    std::filesystem::path image_directory{std::filesystem::temp_directory_path()/"raytracer_bench_precision"};
+    std::set<std::string> suites{};
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--json")
+        {
+            json = true;
+        }
+        else if (argument == "--quick")
+        {
+            quick = true;
+        }
+        else if (argument == "--image-dir" && i + 1 < argc)
+        {
+            image_directory = argv[++i];
+        }
+        else
+        {
+            suites.insert(argument);
+        }
+    }
+    const auto is_selected{[&suites](const std::string& suite)
+    {
+        return suites.empty() || suites.contains(suite);
+    }};
+
+    BenchmarkReport report{};
+    // Cleared by any suite whose check fails, which then fails the run.
+    bool passed{true};
+    const std::filesystem::path output{std::filesystem::temp_directory_path()/"raytracer_bench.ppm"};
+    if (is_selected("scene"))
+    {
+        runSceneBenchmark(report, quick);
+    }
+    if (is_selected("micro"))
+    {
+        runMicroBenchmark(report);
+    }
+    if (is_selected("kernel"))
+    {
+        runKernelBenchmark(report);
+    }
+    if (is_selected("scaling"))
+    {
+        runScalingBenchmark(report, output);
+    }
+    if (is_selected("allocation"))
+    {
+        passed = runAllocationBenchmark(report, output) && passed;
+    }
+    if (is_selected("storage"))
+    {
+        runStorageBenchmark(report, quick);
+    }
+    if (is_selected("materials"))
+    {
+        runMaterialBenchmark(report, output, quick);
+    }
+    if (is_selected("loading"))
+    {
+        runLoadingBenchmark(report, quick);
+    }
+    if (is_selected("motion"))
+    {
+        runMotionBenchmark(report, output);
+    }
+    if (is_selected("roulette"))
+    {
+        runRouletteBenchmark(report, quick);
+    }
+    if (is_selected("sampling"))
+    {
+        runSamplingBenchmark(report, quick);
+    }
+    if (is_selected("denoise"))
+    {
+        runDenoiseBenchmark(report, quick);
+    }
+    if (is_selected("progressive"))
+    {
+        runProgressiveBenchmark(report, quick);
+    }
+    if (is_selected("precision"))
+    {
+        runPrecisionBenchmark(report, image_directory, quick);
+    }
+    std::filesystem::remove(output);
+
+    if (json)
+    {
+        report.writeJSON(std::cout);
+    }
+    else
+    {
+        report.writeCSV(std::cout);
+    }
+    return passed ? 0 : 1;
+}
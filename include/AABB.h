@@ -0,0 +1,32 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include "Interval.h"
+#include "Vec3.h"
+
+class Ray;
+
+struct AABB
+{
+    Interval x{DefinedIntervals::empty};
+    Interval y{DefinedIntervals::empty};
+    Interval z{DefinedIntervals::empty};
+
+    static AABB fromPoints(const Vec3& a, const Vec3& b);
+
+    const Interval& axis(int i) const;
+    int getLongestAxis() const;
+
+    AABB merge(const AABB& box) const;
+    AABB merge(const Vec3& point) const;
+    AABB pad(const Vec3& half_extent) const;
+
+    Vec3 getCentroid() const;
+    Real getSurfaceArea() const;
+    bool isEmpty() const;
+
+    // Slab test using the ray's cached inverse direction and direction signs.
+    bool isHit(const Ray& ray, const Interval& interval) const;
+};
+
+#endif //AABB_H
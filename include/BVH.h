@@ -0,0 +1,133 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "AABB.h"
+#include "Hit.h"
+#include "Interval.h"
+#include "Ray.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct BVHNode
+{
+    AABB bounds{};
+    // Interior nodes store the index of their second child here; the first child always
+    // immediately follows its parent. Leaves store the index of their first primitive.
+    std::uint32_t offset{};
+    // Number of primitives in a leaf, or zero for an interior node.
+    std::uint32_t count{};
+    std::uint32_t axis{};
+};
+
+class BVH
+{
+public:
+    static constexpr size_t default_max_leaf_size{4};
+    static constexpr size_t n_bins{12};
+    static constexpr size_t max_depth{64};
+
+    void build(const std::vector<AABB>& primitive_bounds, size_t leaf_size = default_max_leaf_size);
+
+    size_t size() const {return primitive_indices.size();}
+    bool isEmpty() const {return nodes.empty();}
+    // Primitive indices in leaf order; each leaf covers a contiguous range of this list.
+    const std::vector<std::uint32_t>& getPrimitiveIndices() const {return primitive_indices;}
+
+    // Walks the hierarchy front to back, calling test(index, interval) on primitives in visited
+    // leaves with the interval shrunk to the closest hit found so far.
+    template <typename PrimitiveTest>
+    Hit getClosestHit(const Ray& ray, const Interval& interval, PrimitiveTest&& test) const;
+
+    // As getClosestHit, but calls test(first, count, interval) once per visited leaf with the range
+    // it covers in getPrimitiveIndices(), so a leaf can be tested as one batch.
+    template <typename LeafTest>
+    Hit getClosestLeafHit(const Ray& ray, const Interval& interval, LeafTest&& test) const;
+
+private:
+    struct BuildPrimitive
+    {
+        AABB bounds{};
+        Vec3 centroid{};
+        std::uint32_t index{};
+    };
+
+    size_t buildRecursive(std::vector<BuildPrimitive>& primitives, size_t begin, size_t end, size_t depth);
+    void makeLeaf(size_t node_index, size_t begin, size_t end);
+
+    std::vector<BVHNode> nodes{};
+    std::vector<std::uint32_t> primitive_indices{};
+    size_t max_leaf_size{default_max_leaf_size};
+};
+
+template <typename PrimitiveTest>
+Hit BVH::getClosestHit(const Ray& ray, const Interval& interval, PrimitiveTest&& test) const
+{
+    return getClosestLeafHit(ray, interval, [this, &test](const std::uint32_t first, const std::uint32_t count, const Interval& leaf_interval)
+    {
+        Hit closest_hit{};
+        Real closest_so_far{leaf_interval.max};
+        for (std::uint32_t i{0}; i < count; ++i)
+        {
+            const Hit hit{test(primitive_indices[first + i], Interval{leaf_interval.min, closest_so_far})};
+            if (hit)
+            {
+                closest_so_far = hit.t;
+                closest_hit = hit;
+            }
+        }
+        return closest_hit;
+    });
+}
+
+template <typename LeafTest>
+Hit BVH::getClosestLeafHit(const Ray& ray, const Interval& interval, LeafTest&& test) const
+{
+    Hit closest_hit{};
+    if (nodes.empty())
+    {
+        return closest_hit;
+    }
+    Real closest_so_far{interval.max};
+
+    std::array<std::uint32_t, max_depth> stack{};
+    size_t stack_size{0};
+    std::uint32_t node_index{0};
+    while (true)
+    {
+        const BVHNode& node{nodes[node_index]};
+        if (node.bounds.isHit(ray, Interval{interval.min, closest_so_far}))
+        {
+            if (node.count == 0)
+            {
+                // Descend into the child nearer along the split axis first, so that the far child
+                // is more likely to be culled by closest_so_far when it is popped.
+                if (ray.getDirectionSign(static_cast<int>(node.axis)) != 0)
+                {
+                    stack[stack_size++] = node_index + 1;
+                    node_index = node.offset;
+                }
+                else
+                {
+                    stack[stack_size++] = node.offset;
+                    node_index = node_index + 1;
+                }
+                continue;
+            }
+            const Hit hit{test(node.offset, node.count, Interval{interval.min, closest_so_far})};
+            if (hit)
+            {
+                closest_so_far = hit.t;
+                closest_hit = hit;
+            }
+        }
+        if (stack_size == 0)
+        {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+    return closest_hit;
+}
+
+#endif //BVH_H
@@ -1,10 +1,20 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include "Checkpoint.h"
+#include "Denoiser.h"
+#include "Framebuffer.h"
+#include "ImageWriter.h"
 #include "Vec3.h"
 #include "Ray.h"
+#include "RenderCounters.h"
+#include "Sampler.h"
 #include "Scene.h"
+#include "Utilities.h"
+#include <cstdint>
 #include <fstream>
+#include <functional>
+#include <string>
 
 
 struct CameraConfig
@@ -17,6 +27,104 @@ struct CameraConfig
     double framerate{10.0};
     int anti_aliasing_samples{50};
     int max_depth{10};
+    // Russian roulette ends each path at random once it is roulette_min_depth rays long, surviving
+    // with probability equal to its brightest attenuation channel, and divides the survivors by
+    // that probability so the image stays unbiased. Dim paths stop early, while paths through
+    // clear glass keep going, up to max_depth.
+    bool russian_roulette{false};
+    int roulette_min_depth{3};
+    std::uint64_t seed{0};
+    // Chooses the random numbers of each sample. The low-discrepancy samplers spread a pixel's
+    // samples evenly over where they fall in the pixel, on the lens and in their first bounces.
+    SamplerType sampler{SamplerType::independent};
+    int threads{0}; // Zero uses every hardware thread.
+    int tile_size{16};
+    ImageFormat image_format{ImageFormat::binary_ppm};
+    // Adaptive sampling replaces the fixed anti_aliasing_samples budget: each pixel takes between
+    // min_samples and max_samples, stopping once the standard error of its mean, in gamma-corrected
+    // units, falls to noise_threshold.
+    bool adaptive_sampling{false};
+    int min_samples{16};
+    int max_samples{128};
+    double noise_threshold{0.01};
+    // Writes the per-pixel sample counts alongside the image, as a greyscale "_samples.pgm".
+    bool write_sample_map{false};
+    // Denoising records the albedo, normal and depth of the first diffuse surface each sample meets,
+    // and filters the finished image, guided by them, before it is encoded. Each of the denoise_iterations
+    // doubles how far the filter reaches. write_feature_buffers writes the recorded features beside
+    // the image, as "_albedo" and "_normal" images and a greyscale "_depth.pgm". Both apply to
+    // render, renderAnimation and renderVideo.
+    bool denoise{false};
+    int denoise_iterations{3};
+    bool write_feature_buffers{false};
+    // Progressive rendering replaces the fixed budget with passes of one sample per pixel, after a
+    // preview that traces one pixel in each preview_scale square, and publishes the image after every
+    // pass. It stops once time_budget seconds have passed, once the mean noise over the image, in the
+    // units of noise_threshold, falls to target_noise, or once each pixel has its full budget of
+    // samples; a zero budget or target is never reached. A render left to finish gives the image a
+    // fixed-budget render would. Progressive renders are not denoised.
+    bool progressive{false};
+    double time_budget{2.0};
+    double target_noise{0.0};
+    int preview_scale{8};
+};
+
+// A share of one render's work, so that separate processes can each render part of it and
+// raytracer_merge can combine the results. Tiles are numbered row by row across the tile grid and
+// samples from zero within each pixel; a negative last tile or sample runs to the end. Sample
+// ranges divide the fixed anti-aliasing budget, so adaptive renders should be split by tile.
+struct RenderShard
+{
+    int first_tile{0};
+    int last_tile{-1};
+    int first_sample{0};
+    int last_sample{-1};
+};
+
+// Where a resumable render keeps its progress, and how many seconds pass between saves.
+struct CheckpointConfig
+{
+    std::string filepath{};
+    double interval{300.0};
+};
+
+// The work done by one render, for reporting throughput. Every closest-hit query counts as a ray.
+struct RenderStatistics
+{
+    std::uint64_t n_samples{0};
+    std::uint64_t n_rays{0};
+    double seconds{0.0};
+};
+
+// How a resumable render used its checkpoint, and the work it did. A mismatched checkpoint means
+// nothing was rendered.
+struct ResumableRender
+{
+    Checkpoint::Status checkpoint{Checkpoint::Status::missing};
+    RenderStatistics statistics{};
+};
+
+// How far a progressive render has got when it publishes an image.
+struct ProgressivePass
+{
+    int pass{0}; // The preview is pass 0, and pass n traces each pixel's nth sample.
+    int n_samples{0}; // The fewest samples any pixel has, as the deadline can cut a pass short.
+    double seconds{0.0};
+    double noise{0.0}; // Infinite until every pixel has two samples.
+    bool final{false};
+};
+
+// Hands a render's pixels to the caller as they are finished, as views into the framebuffer being
+// rendered into, so nothing is copied. tile_completed is called from the rendering threads, several
+// at once, as each tile's pixels are stored; the rest of the frame may still be rendering. When
+// denoising, tiles are handed out before the filter changes them. frame_completed is called once
+// the whole frame, denoised if enabled, is in the framebuffer. Progressive renders instead call
+// pass_completed after every pass, and frame_completed after the last.
+struct RenderCallbacks
+{
+    std::function<void(const Tile& tile, const FramebufferView& region)> tile_completed{};
+    std::function<void(const FramebufferView& frame)> frame_completed{};
+    std::function<void(const FramebufferView& frame, const ProgressivePass& pass)> pass_completed{};
 };
 
 class Camera {
@@ -27,26 +135,77 @@ public:
     void rotate(double angle);
     void updateConfig(const CameraConfig& new_config);
 
-    Vec3 sampleOrigin() const;
-
-    void render(Scene& scene, const std::string& filepath, double time = 0.0, bool parallel = true) const;
-    void render(Scene& scene, const std::string& filepath, const Interval& interval, bool parallel = true) const;
+    int getImageWidth() const {return config.image_width;}
+    int getImageHeight() const {return image_height;}
+
+    RenderStatistics render(Scene& scene, const std::string& filepath, Real time = 0, bool parallel = true) const;
+    RenderStatistics render(Scene& scene, const std::string& filepath, const Interval& interval, bool parallel = true) const;
+    RenderStatistics render(Scene& scene, const std::string& filepath, const Interval& interval, const ImageEncoder& encoder, bool parallel = true) const;
+    // Renders into the caller's framebuffer, which must be getImageWidth() by getImageHeight() pixels,
+    // writing nothing to disk. Returns empty statistics, having rendered nothing, if it is not.
+    RenderStatistics render(Scene& scene, const FramebufferView& framebuffer, const Interval& interval, const RenderCallbacks& callbacks = {}, bool parallel = true) const;
+    // Renders into a new framebuffer of the image's size.
+    Framebuffer render(Scene& scene, const Interval& interval, const RenderCallbacks& callbacks = {}, bool parallel = true) const;
+    // In builds with RAYTRACER_STATISTICS, render and renderAnimation also write the render's
+    // counters and phase times as JSON, to "_stats.json" beside the image or the frames.
     void renderAnimation(Scene& scene, const std::string& directory, const Interval& interval, bool motion_blur = false, bool parallel = true, const std::string& filename = "frame") const;
+    // Renders the same frames as renderAnimation, but streams them as a single YUV4MPEG2 video to
+    // filepath, or to stdout if it is "-", so they can be piped straight into an encoder.
+    void renderVideo(Scene& scene, const std::string& filepath, const Interval& interval, bool motion_blur = false, bool parallel = true) const;
+    // Renders one shard and writes it as a partial framebuffer, for raytracer_merge to combine.
+    RenderStatistics renderShard(Scene& scene, const std::string& filepath, const Interval& interval, const RenderShard& shard) const;
+    // Renders like render(), saving every pixel's sample sum and count to the checkpoint file at each
+    // interval, and on SIGTERM, after which the signal is raised again to end the process. A
+    // checkpoint saved by the same render is resumed: finished tiles are kept, and pixels with fewer
+    // samples than the current budget are topped up, giving the image an uninterrupted render would.
+    // A checkpoint saved by a different render is left alone and nothing is rendered.
+    ResumableRender renderResumable(Scene& scene, const std::string& filepath, const Interval& interval, const CheckpointConfig& checkpoint) const;
 
 private:
     void updateParameters();
     void deriveCameraParameters();
     void deriveGeometricParameters();
 
-    void renderSequential(Scene& scene, std::ofstream& file) const;
-    void renderParallel(Scene& scene, std::ofstream& file) const;
-
-    std::vector<Vec3> samplePixel(const Vec3& pixel_location) const;
-    Vec3 colourPixel(const Vec3& pixel_location, Scene& scene) const;
-    Vec3 colourSubpixel(const Vec3& subpixel_location, Scene& scene) const;
-    Vec3 getRandomSubpixel(const Vec3& pixel_location) const;
-
-    Vec3 ray_colour(Ray& ray, const Scene& scene) const;
+    // Renders, encodes and writes one image, adding the time spent on each to times.
+    RenderStatistics renderImage(Scene& scene, const std::string& filepath, const Interval& interval, const ImageEncoder& encoder, bool parallel, RenderCounters::PhaseTimes& times) const;
+    // Fills features with what each pixel's samples first hit, if it is given, and calls tile_finished,
+    // if set, as each tile's pixels are final.
+    RenderStatistics renderFrame(Scene& scene, const Interval& interval, bool parallel, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, const RenderShard& shard = {}, std::vector<PixelFeatures>* features = nullptr, const std::function<void(const Tile&)>& tile_finished = {}) const;
+    // Renders passes until the progressive settings stop it, calling pass_finished with the mean of
+    // every pixel's samples so far after each.
+    RenderStatistics renderProgressive(Scene& scene, const Interval& interval, bool parallel, const std::function<void(const std::vector<Vec3>&, const ProgressivePass&)>& pass_finished) const;
+    // Filters the frame in place if denoising is enabled, returning the seconds it took.
+    double denoiseFrame(std::vector<Vec3>& pixel_colours, const std::vector<PixelFeatures>& features, bool parallel) const;
+    // Calls render_frame(index, interval) for each frame of the animation over the interval.
+    template <typename FrameFunction>
+    void forEachFrame(const Interval& interval, bool motion_blur, FrameFunction&& render_frame) const;
+
+    // Sequential renders finish the image a row at a time, each row being passed on as a tile.
+    std::uint64_t renderSequential(const Scene& scene, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, std::vector<PixelFeatures>* features, const std::function<void(const Tile&)>& tile_finished) const;
+    std::uint64_t renderParallel(const Scene& scene, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, const RenderShard& shard, std::vector<PixelFeatures>* features, const std::function<void(const Tile&)>& tile_finished) const;
+    std::uint64_t renderPixel(int i, int j, const Scene& scene, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, const RenderShard& shard = {}, std::vector<PixelFeatures>* features = nullptr) const;
+    void reportSampleCounts(const std::string& filepath, const std::vector<int>& sample_counts) const;
+    void writeFeatureBuffers(const std::string& filepath, const std::vector<PixelFeatures>& features) const;
+    void reportCounters(const std::string& filepath, const RenderCounters::PhaseTimes& times) const;
+
+    Vec3 getPixelLocation(int i, int j) const;
+    // Adds samples [first_sample, last_sample) of the pixel to sum, in order.
+    Vec3 accumulateSamples(const Vec3& pixel_location, std::uint64_t pixel_index, const Scene& scene, int first_sample, int last_sample, Vec3 sum, std::uint64_t& n_rays, PixelFeatures* features = nullptr) const;
+    Vec3 colourPixelAdaptive(const Vec3& pixel_location, std::uint64_t pixel_index, const Scene& scene, int& n_samples, std::uint64_t& n_rays, PixelFeatures* features = nullptr) const;
+    bool isConverged(double luminance_mean, double luminance_m2, int n_samples) const;
+    // The standard error of a pixel's mean, as it appears once gamma corrected.
+    static double getDisplayError(double luminance_mean, double luminance_m2, int n_samples);
+    // The samples a pixel may take, over which stratified sampling spreads its strata.
+    int getSampleBudget() const;
+    // A hash of everything besides the size, seed and sampler that decides a pixel's samples, by
+    // which a checkpoint recognises the render that saved it.
+    std::uint64_t getFingerprint(const Scene& scene, const Interval& interval) const;
+    Sampler makeSampler(std::uint64_t pixel_index, int sample) const;
+    Vec3 getSubpixel(const Vec3& pixel_location, int sample, Sampler& sampler, Random::Generator& pixel_generator) const;
+    Vec3 colourSubpixel(const Vec3& subpixel_location, const Scene& scene, Sampler& sampler, std::uint64_t& n_rays, SampleFeatures* features = nullptr) const;
+    Vec3 getRandomSubpixel(const Vec3& pixel_location, Random::Generator& generator) const;
+
+    Vec3 ray_colour(Ray& ray, const Scene& scene, Sampler& sampler, std::uint64_t& n_rays, SampleFeatures* features = nullptr) const;
     Vec3 background_colour(const Ray& ray) const;
 
     CameraConfig config{};
@@ -56,8 +215,8 @@ private:
     double twist{};
 
     int image_height{};
-    double viewport_height{};
-    double viewport_width{};
+    Real viewport_height{};
+    Real viewport_width{};
 
     Vec3 viewport_dx{};
     Vec3 viewport_dy{};
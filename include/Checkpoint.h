@@ -0,0 +1,42 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Sampler.h"
+#include "Vec3.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The saved progress of a resumable render: for every pixel, the running sum of the samples traced
+// so far and how many there were. Sums are kept in double, which holds a Real exactly, so a resumed
+// render carries on from precisely where the interrupted one stopped.
+namespace Checkpoint
+{
+    // What the samples of a render depend on. The fingerprint is a hash of the camera, the scene
+    // and every setting that changes what a pixel's samples are.
+    struct Identity
+    {
+        int width{};
+        int height{};
+        std::uint64_t seed{};
+        SamplerType sampler{};
+        std::uint64_t fingerprint{};
+    };
+
+    enum class Status
+    {
+        resumed,
+        missing,
+        mismatched
+    };
+
+    // Writes to a temporary file first and renames it over the old checkpoint, so being killed
+    // part way through a save never loses the previous one.
+    bool write(const std::string& filepath, const Identity& identity, const std::vector<Vec3>& sums, const std::vector<int>& sample_counts);
+
+    // Leaves the outputs untouched unless the checkpoint is resumed. A file that is absent or
+    // malformed is missing, and one saved by a render with a different identity is mismatched.
+    Status read(const std::string& filepath, const Identity& identity, std::vector<Vec3>& sums, std::vector<int>& sample_counts);
+}
+
+#endif //CHECKPOINT_H
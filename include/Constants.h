@@ -1,12 +1,12 @@
-
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include "Precision.h"
 #include <limits>
 
 namespace Constants
 {
-    constexpr double infinity{std::numeric_limits<double>::infinity()};
+    constexpr Real infinity{std::numeric_limits<Real>::infinity()};
 }
 
 #endif //CONSTANTS_H
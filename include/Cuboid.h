@@ -9,39 +9,38 @@ public:
     Cuboid(const Vec3& origin, const Vec3& dimensions, const Material& material, const Dynamics& dynamics)
         :
         HittableEntity(origin, material, dynamics),
-        dimensions{dimensions},
-        lower_bounds{origin - 0.5*dimensions},
-        upper_bounds{origin + 0.5*dimensions}
+        half_dimensions{0.5*dimensions}
     {
     }
 
     Cuboid(const Vec3& origin, const Vec3& dimensions, const Material& material)
         :
         HittableEntity(origin, material),
-        dimensions{dimensions},
-        lower_bounds{origin - 0.5*dimensions},
-        upper_bounds{origin + 0.5*dimensions}
+        half_dimensions{0.5*dimensions}
     {
     }
 
     // Is this needed or equivalent to a default constructor?
     Cuboid(const Cuboid& cuboid)
         : HittableEntity(cuboid),
-          dimensions{cuboid.dimensions},
-          lower_bounds{cuboid.lower_bounds},
-          upper_bounds(cuboid.upper_bounds)
+          half_dimensions{cuboid.half_dimensions}
     {
     }
 
     Hit getRayHit(const Ray& ray, const Interval& interval) const override;
+    AABB getBoundingBox(const Interval& time) const override;
+
+    const Vec3& getHalfDimensions() const {return half_dimensions;}
+
+    // Intersects a cuboid with the given half dimensions centred on position. Scenes call this
+    // directly on the cuboids they store, without building a Cuboid.
+    static Hit getRayHit(const Vec3& position, const Vec3& half_dimensions, Materials::Index material, const Ray& ray, const Interval& interval);
 
 private:
-    Vec3 getNormalAtPoint(const Vec3& point) const;
-    Interval getRayIntersection(const Ray& ray) const;
+    static Vec3 getNormalAtPoint(const Vec3& point, const Vec3& position, const Vec3& half_dimensions);
+    static Interval getRayIntersection(const Ray& ray, const Vec3& position, const Vec3& half_dimensions);
 
-    Vec3 dimensions{};
-    Vec3 lower_bounds{};
-    Vec3 upper_bounds{};
+    Vec3 half_dimensions{};
 };
 
 #endif //RAYTRACER_CUBOID_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include "Vec3.h"
+#include <vector>
+
+// What one sample saw where its path first met a diffuse surface, seen through any mirrors and glass
+// on the way: the surface's albedo tinted by theirs, its normal, and the length of the path to it.
+// A path that escapes first records the background as its albedo and faces back along its ray.
+struct SampleFeatures
+{
+    Vec3 albedo{};
+    Vec3 normal{};
+    Real depth{0};
+};
+
+// The features of a pixel's samples, summed, along with the moments of each sample's luminance
+// once its albedo is divided out, from which the denoiser estimates how noisy the pixel is.
+struct PixelFeatures
+{
+    Vec3 albedo{};
+    Vec3 normal{};
+    Real depth{0};
+    double luminance{0.0};
+    double luminance_squared{0.0};
+    int n_samples{0};
+
+    void add(const SampleFeatures& sample, const Vec3& colour);
+};
+
+namespace Denoiser
+{
+    // Albedo below this is treated as this when dividing it out, so black surfaces keep their noise.
+    constexpr Real min_albedo{static_cast<Real>(0.001)};
+
+    // Filters each pixel's colour with an edge-avoiding à-trous wavelet (Dammertz et al., 2010),
+    // steered by the variance of each pixel as in SVGF (Schied et al., 2017). The albedo is divided
+    // out first so texture survives the filter, and the remaining lighting is only blended between
+    // pixels whose normals, depths and luminance agree. Each iteration doubles the filter's reach,
+    // up to the size of the image, and runs over tiles on the given number of threads.
+    void denoise(std::vector<Vec3>& pixel_colours, const std::vector<PixelFeatures>& features, int width, int height, int iterations, int tile_size, int n_threads);
+
+    // The averaged albedos, normals mapped from [-1, 1] to [0, 1], and depths scaled by the
+    // deepest, each as an image.
+    std::vector<Vec3> getAlbedoImage(const std::vector<PixelFeatures>& features);
+    std::vector<Vec3> getNormalImage(const std::vector<PixelFeatures>& features);
+    std::vector<double> getDepthImage(const std::vector<PixelFeatures>& features);
+}
+
+#endif //DENOISER_H
@@ -1,6 +1,11 @@
 #ifndef RAYTRACER_DYNAMICS_H
 #define RAYTRACER_DYNAMICS_H
 
+#include "AABB.h"
+#include "Interval.h"
+#include "Vec3.h"
+#include <memory>
+
 struct State
 {
     Vec3 position{};
@@ -10,7 +15,12 @@ struct State
 class Dynamics
 {
 public:
-    virtual State at(double time) = 0;
+    virtual State at(Real time) const = 0;
+
+    // Bounds every position taken over the given time interval.
+    virtual AABB sweep(const Interval& time) const = 0;
+
+    virtual bool isStatic() const {return false;}
 
     virtual ~Dynamics() = default;
 
@@ -24,11 +34,18 @@ public:
         : position{position}
     {}
 
-    State at([[maybe_unused]] double time) override
+    State at([[maybe_unused]] Real time) const override
     {
         return {position, {0.0,0.0,0.0}};
     }
 
+    AABB sweep([[maybe_unused]] const Interval& time) const override
+    {
+        return AABB::fromPoints(position, position);
+    }
+
+    bool isStatic() const override {return true;}
+
     std::unique_ptr<Dynamics> make_unique() const override
     {
         return std::make_unique<Static>(*this);
@@ -45,17 +62,46 @@ public:
         : position{position}, velocity{velocity}, acceleration{acceleration}
     {}
 
-    State at(const double time) override
+    State at(const Real time) const override
     {
         return {position + velocity*time + 0.5*acceleration*time*time, velocity + acceleration*time};
     }
 
+    AABB sweep(const Interval& time) const override
+    {
+        AABB bounds{AABB::fromPoints(positionAt(time.min), positionAt(time.max))};
+        // Each coordinate is a parabola in time, so its extremum may lie strictly inside the interval.
+        for (int i{0}; i < 3; ++i)
+        {
+            if (acceleration[i] != 0)
+            {
+                const Real turning_time{-velocity[i]/acceleration[i]};
+                if (time.min < turning_time && turning_time < time.max)
+                {
+                    bounds = bounds.merge(positionAt(turning_time));
+                }
+            }
+        }
+        return bounds;
+    }
+
     std::unique_ptr<Dynamics> make_unique() const override
     {
         return std::make_unique<Newtonian>(*this);
     }
 
+    const Vec3& getPosition() const {return position;}
+    const Vec3& getVelocity() const {return velocity;}
+    const Vec3& getAcceleration() const {return acceleration;}
+
+    // The closed form behind at(), callable without going through the vtable.
+    Vec3 positionAt(const Real time) const
+    {
+        return position + velocity*time + 0.5*acceleration*time*time;
+    }
+
 private:
+
     Vec3 position{};
     Vec3 velocity{};
     Vec3 acceleration{};
@@ -0,0 +1,48 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "TileScheduler.h"
+#include "Vec3.h"
+#include <cstddef>
+#include <vector>
+
+// A window onto linear RGB pixels held as 32-bit floats, three to a pixel, rows running from the
+// top with stride floats from the start of one to the start of the next. The pixels belong to
+// whoever made the view; copying the view never copies them.
+struct FramebufferView
+{
+    float* data{nullptr};
+    int width{0};
+    int height{0};
+    std::size_t stride{0};
+
+    float* getPixel(const int i, const int j) const {return data + static_cast<std::size_t>(j)*stride + 3*static_cast<std::size_t>(i);}
+    // The rectangle [x_min, x_max) by [y_min, y_max) of this view, sharing its pixels and stride.
+    FramebufferView getRegion(const Tile& tile) const {return {getPixel(tile.x_min, tile.y_min), tile.x_max - tile.x_min, tile.y_max - tile.y_min, stride};}
+    // Whether the view is of an image of the given size, with room for each of its rows.
+    bool hasSize(int image_width, int image_height) const;
+
+    // Stores the tile's pixels from colours, a whole frame of this view's size, as floats.
+    void store(const std::vector<Vec3>& colours, const Tile& tile) const;
+    void store(const std::vector<Vec3>& colours) const;
+};
+
+// A framebuffer that owns its pixels, packed with no padding between rows.
+class Framebuffer
+{
+public:
+    Framebuffer() = default;
+    Framebuffer(int width, int height);
+
+    int getWidth() const {return width;}
+    int getHeight() const {return height;}
+    const std::vector<float>& getData() const {return pixels;}
+    FramebufferView getView() {return {pixels.data(), width, height, 3*static_cast<std::size_t>(width)};}
+
+private:
+    int width{0};
+    int height{0};
+    std::vector<float> pixels{};
+};
+
+#endif //FRAMEBUFFER_H
@@ -3,21 +3,25 @@
 
 #include "Vec3.h"
 #include "Material.h"
+#include <limits>
 
 struct Hit
 {
-    double t{};
+    static constexpr Materials::Index no_material{std::numeric_limits<Materials::Index>::max()};
+
+    Real t{};
     Vec3 point{};
     Vec3 normal{};
-    const Material* material{nullptr};
+    // Index into the material table of the scene the hit entity belongs to.
+    Materials::Index material{no_material};
 
     Hit() = default;
 
-    Hit(const double t, const Vec3& point, const Vec3& normal, const Material& material)
-        : t{t}, point{point}, normal{normal}, material{&material}
+    Hit(const Real t, const Vec3& point, const Vec3& normal, const Materials::Index material)
+        : t{t}, point{point}, normal{normal}, material{material}
     {}
 
-    explicit operator bool() const {return material != nullptr;}
+    explicit operator bool() const {return material != no_material;}
 };
 
 #endif //HIT_H
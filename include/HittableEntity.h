@@ -1,6 +1,7 @@
 #ifndef HITTABLEENTITY_H
 #define HITTABLEENTITY_H
 
+#include "AABB.h"
 #include "Ray.h"
 #include "Hit.h"
 #include "Dynamics.h"
@@ -8,12 +9,12 @@
 #include "Material.h"
 #include <memory>
 
-bool inRange(double x, double a, double b);
+bool inRange(Real x, Real a, Real b);
 
 class HittableEntity {
 public:
     HittableEntity(const Vec3& origin, const Material& material, const Dynamics& dynamics)
-        : material{material.make_unique()}, origin{origin}, dynamics{dynamics.make_unique()}
+        : material{material}, origin{origin}, dynamics{dynamics.make_unique()}
     {}
 
     HittableEntity(const Vec3& origin, const Material& material)
@@ -21,22 +22,31 @@ public:
     {}
 
     explicit HittableEntity(const HittableEntity& entity)
-        : HittableEntity(entity.origin, *entity.material, *entity.dynamics)
-    {}
+        : HittableEntity(entity.origin, entity.material, *entity.dynamics)
+    {
+        material_index = entity.material_index;
+    }
 
     virtual ~HittableEntity() = default;
     virtual Hit getRayHit(const Ray& ray, const Interval& interval) const = 0;
-    virtual void at(double time);
+    virtual AABB getBoundingBox(const Interval& time) const = 0;
+
+    // Entities are never moved in place; each intersection evaluates the dynamics at the ray's time.
+    Vec3 getPosition(const Real time) const {return dynamics->at(time).position;}
 
-    const Material& getMaterial() const {return *material;}
+    const Material& getMaterial() const {return material;}
+    const Dynamics& getDynamics() const {return *dynamics;}
+
+    // Hits report this index. It is zero until a scene adds the entity and points it at its
+    // material table instead.
+    Materials::Index getMaterialIndex() const {return material_index;}
+    void setMaterialIndex(const Materials::Index index) {material_index = index;}
 
 private:
-    const std::unique_ptr<Material> material{nullptr};
+    Material material;
+    Materials::Index material_index{0};
     Vec3 origin{};
     const std::unique_ptr<Dynamics> dynamics{nullptr};
-
-protected:
-    Vec3 position{};
 };
 
 #endif //HITTABLEENTITY_H
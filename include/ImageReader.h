@@ -0,0 +1,15 @@
+#ifndef IMAGEREADER_H
+#define IMAGEREADER_H
+
+#include "Vec3.h"
+#include <string>
+#include <vector>
+
+namespace ImageReader
+{
+    // Reads a colour PFM as written by PFMEncoder, returning rows top-down. Returns false, leaving
+    // the outputs untouched, if the file is missing or is not a colour PFM.
+    bool readPFM(const std::string& filepath, std::vector<Vec3>& pixels, int& width, int& height);
+}
+
+#endif //IMAGEREADER_H
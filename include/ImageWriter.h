@@ -0,0 +1,66 @@
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+#include "Vec3.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class ImageFormat
+{
+    ascii_ppm,  // P3, the original text output.
+    binary_ppm, // P6, 8 bits per channel after gamma correction.
+    pfm,        // Portable float map: linear 32-bit float per channel, for HDR.
+};
+
+// Turns a finished frame of linear RGB colours, stored row by row from the top, into file bytes.
+class ImageEncoder
+{
+public:
+    virtual ~ImageEncoder() = default;
+
+    // Appends the whole encoded frame, header included, to the buffer.
+    virtual void encode(const std::vector<Vec3>& pixels, int width, int height, std::string& buffer) const = 0;
+};
+
+class AsciiPPMEncoder : public ImageEncoder
+{
+public:
+    void encode(const std::vector<Vec3>& pixels, int width, int height, std::string& buffer) const override;
+};
+
+class BinaryPPMEncoder : public ImageEncoder
+{
+public:
+    void encode(const std::vector<Vec3>& pixels, int width, int height, std::string& buffer) const override;
+};
+
+class PFMEncoder : public ImageEncoder
+{
+public:
+    void encode(const std::vector<Vec3>& pixels, int width, int height, std::string& buffer) const override;
+};
+
+namespace ImageWriter
+{
+    std::unique_ptr<ImageEncoder> makeEncoder(ImageFormat format);
+    const char* getExtension(ImageFormat format);
+
+    std::string getPPMHeader(bool binary, int width, int height);
+
+    // Gamma corrects and quantises one channel to 0-255, as PGM::thresholdColour(PGM::linearToGamma(x)).
+    std::uint8_t quantise(double channel);
+    // The same over every channel of a frame, using vector instructions where the CPU has them.
+    void quantise(const std::vector<Vec3>& pixels, std::uint8_t* output);
+
+    // Writes values in [0, 1] as an 8-bit binary greyscale PGM, without gamma correction.
+    void writeGreyscale(const std::string& filepath, const std::vector<double>& values, int width, int height);
+
+    // Encodes the frame into one contiguous buffer and writes it with a single call.
+    void write(const std::string& filepath, const std::vector<Vec3>& pixels, int width, int height, const ImageEncoder& encoder);
+    // Writes an already encoded frame with a single call.
+    void writeBuffer(const std::string& filepath, const std::string& buffer);
+}
+
+#endif //IMAGEWRITER_H
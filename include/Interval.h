@@ -2,16 +2,37 @@
 #define INTERVAL_H
 
 #include "Constants.h"
+#include <algorithm>
 
-struct Interval
+template <typename T = double>
+struct IntervalT
 {
-    double min{};
-    double max{};
+    T min{};
+    T max{};
 
-    bool contains(double x) const;
-    Interval intersect(const Interval& interval) const;
+    bool contains(const T x) const
+    {
+        return min <= x && x <= max;
+    }
+
+    T size() const
+    {
+        return max - min;
+    }
+
+    IntervalT intersect(const IntervalT& interval) const
+    {
+        return IntervalT{std::max(min, interval.min), std::min(max, interval.max)};
+    }
+
+    IntervalT merge(const IntervalT& interval) const
+    {
+        return IntervalT{std::min(min, interval.min), std::max(max, interval.max)};
+    }
 };
 
+using Interval = IntervalT<Real>;
+
 namespace DefinedIntervals
 {
     static constexpr Interval empty{Constants::infinity, -Constants::infinity};
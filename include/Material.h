@@ -3,65 +3,103 @@
 
 #include "Vec3.h"
 #include "Ray.h"
-#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 
-struct Material {
+class Sampler;
+
+// Materials are plain parameter sets. A scene keeps one table of the distinct materials its
+// entities use, and shading dispatches on the alternative held rather than through a vtable.
+struct Lambertian
+{
     Vec3 albedo{};
 
-    explicit Material(const Vec3& albedo)
+    explicit Lambertian(const Vec3& albedo)
         : albedo{albedo}
     {}
 
-    virtual Vec3 attenuate(Ray& ray, const Vec3& point, const Vec3& normal) const = 0;
-
-    virtual std::unique_ptr<Material> make_unique() const = 0;
+    Vec3 attenuate(Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler) const;
 
-    virtual ~Material() = default;
+    bool operator==(const Lambertian&) const = default;
 };
 
-struct Lambertian : Material
+struct Reflector
 {
-    explicit Lambertian(const Vec3& albedo)
-        : Material(albedo)
-    {}
+    Vec3 albedo{};
+    Real fuzz{};
 
-    Vec3 attenuate(Ray& ray, const Vec3& point, const Vec3& normal) const override;
+    Reflector(const Vec3& albedo, const double fuzz)
+        : albedo{albedo}, fuzz{static_cast<Real>(fuzz)}
+    {}
 
-    std::unique_ptr<Material> make_unique() const override;
+    Vec3 attenuate(Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler) const;
 
+    bool operator==(const Reflector&) const = default;
 };
 
-struct Reflector : Material
+struct Refractor
 {
-    double fuzz{};
+    Vec3 albedo{};
+    Real refractive_index{0};
 
-    Reflector(const Vec3& albedo, double fuzz)
-        : Material(albedo), fuzz{fuzz}
+    Refractor(const Vec3& albedo, const double refractive_index)
+        : albedo{albedo}, refractive_index{static_cast<Real>(refractive_index)}
     {}
 
-    Vec3 attenuate(Ray& ray, const Vec3& point, const Vec3& normal) const override;
+    Vec3 attenuate(Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler) const;
 
-    std::unique_ptr<Material> make_unique() const override;
+    bool operator==(const Refractor&) const = default;
 
+    static Real computeCosineTerm(const Vec3& normalised_direction, const Vec3& normal);
+    static bool canRefract(Real cosine_term, Real refractive_ratio);
+    static bool doesRefract(Real cosine_term, Real refractive_ratio, Sampler& sampler);
+    static Real computeSchickApproximation(Real cosine_term, Real refractive_ratio);
 };
 
-struct Refractor : Material
-{
-    double refractive_index{0};
+using Material = std::variant<Lambertian, Reflector, Refractor>;
 
-    Refractor(const Vec3& albedo, double refractive_index)
-        : Material(albedo), refractive_index{refractive_index}
-    {}
+namespace Materials
+{
+    // Index of a material in its scene's table.
+    using Index = std::uint32_t;
+
+    // Scatters the ray off the surface and returns the attenuation it picks up there. Dispatches
+    // with a switch on the held alternative, which inlines each material's own attenuate.
+    Vec3 attenuate(const Material& material, Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler);
+
+    // The colour the material tints the light it scatters, whichever kind it is.
+    inline const Vec3& getAlbedo(const Material& material)
+    {
+        return std::visit([](const auto& alternative) -> const Vec3& {return alternative.albedo;}, material);
+    }
+
+    // Hashes every parameter, so equal materials can be found when building a scene's table.
+    struct Hash
+    {
+        size_t operator()(const Material& material) const;
+    };
+}
+
+// The distinct materials of a scene, each stored once. Adding a material equal to one already held
+// returns that entry's index, so every primitive with the same material refers to the same entry.
+class MaterialLibrary
+{
+public:
+    Materials::Index add(const Material& material);
 
-    Vec3 attenuate(Ray& ray, const Vec3& point, const Vec3& normal) const override;
+    const Material& operator[](const Materials::Index index) const {return materials[index];}
+    const std::vector<Material>& getMaterials() const {return materials;}
+    size_t size() const {return materials.size();}
+    bool empty() const {return materials.empty();}
 
-    std::unique_ptr<Material> make_unique() const override;
+    // Approximate heap bytes held, counting the hash table used to find equal materials.
+    size_t getMemoryUsage() const;
 
-    static double computeCosineTerm(const Vec3& normalised_direction, const Vec3& normal);
-    static bool canRefract(double cosine_term, double refractive_ratio);
-    static bool doesRefract(double cosine_term, double refractive_ratio);
-    static double computeSchickApproximation(double cosine_term, double refractive_ratio);
+private:
+    std::vector<Material> materials{};
+    std::unordered_map<Material, Materials::Index, Materials::Hash> indices{};
 };
 
-
 #endif //MATERIAL_H
@@ -1,11 +1,13 @@
 #ifndef OUTPUTFORMAT_H
 #define OUTPUTFORMAT_H
 
+#include "ImageWriter.h"
 #include "Vec3.h"
 #include <cassert>
 #include <cmath>
 #include <fstream>
 
+// Pixel-at-a-time ASCII output, kept for compatibility. Whole frames go through ImageWriter.
 namespace PGM
 {
     constexpr int max_colour{255};
@@ -27,16 +29,16 @@ namespace PGM
 
     inline void writeHeader(std::ofstream& file, const int width, const int height)
     {
-        file << "P3\n" << width << " " << height << "\n" << max_colour << "\n";
+        file << ImageWriter::getPPMHeader(false, width, height);
     }
 
     inline void writeRGBTriple(std::ofstream& file, const Vec3& rgb)
     {
         assert(rgb[0] <= 1.0 && rgb[1] <= 1.0 && rgb[2] <= 1.0);
         assert(rgb[0] >= 0.0 && rgb[1] >= 0.0 && rgb[2] >= 0.0);
-        file << thresholdColour(linearToGamma(rgb[0])) << " "
-                  << thresholdColour(linearToGamma(rgb[1])) << " "
-                  << thresholdColour(linearToGamma(rgb[2])) << "\n";
+        file << static_cast<int>(ImageWriter::quantise(rgb[0])) << " "
+                  << static_cast<int>(ImageWriter::quantise(rgb[1])) << " "
+                  << static_cast<int>(ImageWriter::quantise(rgb[2])) << "\n";
     }
 }
 
@@ -0,0 +1,130 @@
+#ifndef PACKEDPRIMITIVES_H
+#define PACKEDPRIMITIVES_H
+
+#include "Interval.h"
+#include "Ray.h"
+#include "Vec3.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// Packs are held in double whatever precision the renderer is built in, so a single set of
+// kernels serves every build.
+using PackedVec3 = Vec3T<double>;
+using PackedInterval = IntervalT<double>;
+
+// Hands out storage aligned to a cache line, which also suits the widest vector registers.
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator([[maybe_unused]] const AlignedAllocator<U, Alignment>& allocator)
+    {}
+
+    T* allocate(const std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* pointer, [[maybe_unused]] const std::size_t n) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t{Alignment});
+    }
+
+    friend bool operator==(const AlignedAllocator&, const AlignedAllocator&) {return true;}
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Structure-of-arrays copies of static spheres, so one ray can be tested against several at once.
+// The arrays are padded with inert entries, letting kernels load a whole register past the end.
+struct SpherePack
+{
+    AlignedVector<double> centre_x{};
+    AlignedVector<double> centre_y{};
+    AlignedVector<double> centre_z{};
+    AlignedVector<double> radius{};
+    // Index of the scene's sphere or cuboid record each packed entry was copied from.
+    std::vector<std::uint32_t> primitive{};
+
+    size_t size() const {return primitive.size();}
+    void clear();
+    void add(const Vec3& centre, double sphere_radius, std::uint32_t primitive_index);
+    void pad();
+};
+
+struct CuboidPack
+{
+    AlignedVector<double> lower_x{};
+    AlignedVector<double> lower_y{};
+    AlignedVector<double> lower_z{};
+    AlignedVector<double> upper_x{};
+    AlignedVector<double> upper_y{};
+    AlignedVector<double> upper_z{};
+    std::vector<std::uint32_t> primitive{};
+
+    size_t size() const {return primitive.size();}
+    void clear();
+    void add(const Vec3& lower_bounds, const Vec3& upper_bounds, std::uint32_t primitive_index);
+    void pad();
+};
+
+// Terms of a ray shared by every packed test against it.
+struct PackedRay
+{
+    PackedVec3 origin{};
+    PackedVec3 direction{};
+    PackedVec3 inverse_direction{};
+    double length_squared{};
+
+    explicit PackedRay(const Ray& ray);
+};
+
+// The nearest primitive a kernel found in its range, as an index into the pack.
+struct PackedHit
+{
+    std::int64_t index{-1};
+    double t{};
+
+    explicit operator bool() const {return index >= 0;}
+};
+
+namespace PackedKernels
+{
+    enum class InstructionSet
+    {
+        scalar,
+        avx2,
+        avx512,
+    };
+
+    // Enough padding for the widest register, in doubles.
+    constexpr size_t padding{8};
+
+    using SphereKernel = PackedHit (*)(const SpherePack& pack, size_t first, size_t count, const PackedRay& ray, const PackedInterval& interval);
+    using CuboidKernel = PackedHit (*)(const CuboidPack& pack, size_t first, size_t count, const PackedRay& ray, const PackedInterval& interval);
+
+    bool isSupported(InstructionSet instruction_set);
+    // Detected once, from the widest instruction set the running CPU supports.
+    InstructionSet getBestInstructionSet();
+    const char* getName(InstructionSet instruction_set);
+
+    // The kernels follow the root and edge selection of Sphere::getRayHit and Cuboid::getRayHit,
+    // returning the primitive with the smallest such t inside the interval.
+    SphereKernel getSphereKernel(InstructionSet instruction_set = getBestInstructionSet());
+    CuboidKernel getCuboidKernel(InstructionSet instruction_set = getBestInstructionSet());
+}
+
+#endif //PACKEDPRIMITIVES_H
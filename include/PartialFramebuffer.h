@@ -0,0 +1,41 @@
+#ifndef PARTIALFRAMEBUFFER_H
+#define PARTIALFRAMEBUFFER_H
+
+#include "Vec3.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The part of a render produced by one shard: for each pixel, the mean of the samples the shard
+// traced there and how many it traced. Pixels outside the shard's tiles have no samples. Shards of
+// one render merge by stitching their pixels together, averaging any pixel several of them sampled
+// weighted by their sample counts.
+class PartialFramebuffer
+{
+public:
+    PartialFramebuffer() = default;
+    PartialFramebuffer(int width, int height);
+    PartialFramebuffer(int width, int height, const std::vector<Vec3>& colours, const std::vector<int>& sample_counts);
+
+    int getWidth() const {return width;}
+    int getHeight() const {return height;}
+    const std::vector<Vec3>& getColours() const {return colours;}
+    const std::vector<std::uint32_t>& getSampleCounts() const {return sample_counts;}
+
+    // Returns false, leaving this framebuffer unchanged, if the sizes differ.
+    bool merge(const PartialFramebuffer& partial);
+
+    // Only sampled pixels are stored, as runs along rows, in 32-bit floats and the byte order of
+    // the machine that wrote them.
+    bool write(const std::string& filepath) const;
+    // Returns false, leaving the framebuffer unchanged, if the file is missing or malformed.
+    bool read(const std::string& filepath);
+
+private:
+    int width{0};
+    int height{0};
+    std::vector<Vec3> colours{};
+    std::vector<std::uint32_t> sample_counts{};
+};
+
+#endif //PARTIALFRAMEBUFFER_H
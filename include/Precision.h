@@ -0,0 +1,22 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+// The scalar type the renderer is built in. The math types are templates, and the rest of the
+// renderer follows this choice; build with RAYTRACER_SINGLE_PRECISION for a float renderer.
+#ifdef RAYTRACER_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
+
+namespace Precision
+{
+    // Bounced rays ignore hits closer than this, so they do not re-hit the surface they leave
+    // through rounding error. Float needs a wider margin: at 1e-4 its benchmark images drift
+    // several times further from the double renders than at 3e-3.
+    constexpr Real ray_epsilon{sizeof(Real) < sizeof(double) ? static_cast<Real>(3e-3) : static_cast<Real>(1e-3)};
+
+    constexpr const char* name{sizeof(Real) < sizeof(double) ? "float" : "double"};
+}
+
+#endif //PRECISION_H
@@ -2,37 +2,64 @@
 #define RAY_H
 
 #include "Vec3.h"
-#include <vector>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class Sampler;
 
 class Ray {
 public:
+    // A path enters at most one medium per bounce, so the refraction stack never needs more than
+    // max_depth + 1 entries. It is held inline to keep rays off the heap, and scene files reject a
+    // max_depth it could not hold. Paths of cameras configured deeper in code that nest beyond this
+    // capacity keep refracting relative to the innermost medium that was recorded.
+    static constexpr size_t max_nested_media{16};
 
-    Ray(const Vec3& origin, const Vec3& direction, const double initial_refractive_index)
-        : points{origin}, direction{direction}, refraction_log{initial_refractive_index}
+    Ray(const Vec3& origin, const Vec3& direction, const Real initial_refractive_index, const Real time = 0.0)
+        : origin{origin}, direction{direction}, refraction_log{initial_refractive_index}, time{time}
     {
-        // Update this to be the space for max_bounce.
-        // Also refractive_index vec can be less than the number of objects in the scene.
-        // Or would that be too crazy on memory?
+        cacheDirectionTerms();
     }
 
-    Vec3 at(double t) const;
-    double at(const Vec3& point_on_ray) const;
+    Vec3 at(Real t) const;
+    Real at(const Vec3& point_on_ray) const;
 
     const Vec3& getDirection() const {return direction;}
-    const Vec3& getOrigin() const {return points.back();}
+    const Vec3& getOrigin() const {return origin;}
+    // Terms of the direction that intersection tests share, recomputed whenever the direction
+    // changes rather than by every test. Axes the ray runs along have an infinite inverse.
+    const Vec3& getInverseDirection() const {return inverse_direction;}
+    // 1 along each axis the ray heads towards negative coordinates, so a slab test can pick the
+    // near and far faces of a box without comparing them.
+    size_t getDirectionSign(const int axis) const {return (direction_signs >> axis) & 1u;}
+    Real getLengthSquared() const {return length_squared;}
+    const Vec3& getUnitDirection() const {return unit_direction;}
+    // The instant the ray was sampled at; every bounce of the path sees the scene at this time.
+    Real getTime() const {return time;}
 
-    void reflect(const Vec3& at_point, const Vec3& at_normal, double fuzz);
-    void scatter(const Vec3& at_point, const Vec3& at_normal);
-    void refract(const Vec3& at_point, const Vec3& at_normal, double refractive_index, double cosine_term, bool entering);
+    void reflect(const Vec3& at_point, const Vec3& at_normal, Real fuzz, Sampler& sampler);
+    void scatter(const Vec3& at_point, const Vec3& at_normal, Sampler& sampler);
+    void refract(const Vec3& at_point, const Vec3& at_normal, Real refractive_index, Real cosine_term, bool entering);
 
-    double getRefractiveRatio(bool entering, double refractive_index=1.0);
+    Real getRefractiveRatio(bool entering, Real refractive_index=1.0);
 
 private:
     void update(const Vec3& at_position, const Vec3& in_direction);
+    void cacheDirectionTerms();
+    void enterMedium(Real refractive_index);
+    void exitMedium();
 
-    std::vector<Vec3> points{};
+    Vec3 origin{};
     Vec3 direction{};
-    std::vector<double> refraction_log{};
+    Vec3 inverse_direction{};
+    Vec3 unit_direction{};
+    Real length_squared{};
+    std::uint8_t direction_signs{};
+    std::array<Real, max_nested_media> refraction_log{};
+    size_t n_recorded_media{1};
+    size_t n_unrecorded_media{0};
+    Real time{};
 };
 
 
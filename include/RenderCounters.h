@@ -0,0 +1,113 @@
+#ifndef RENDERCOUNTERS_H
+#define RENDERCOUNTERS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Tallies of what a render spends its work on, kept per thread so that counting never contends.
+// They are only collected in builds with RAYTRACER_STATISTICS; otherwise every counting call is an
+// empty inline function and the instrumentation compiles away.
+namespace RenderCounters
+{
+#ifdef RAYTRACER_STATISTICS
+    constexpr bool enabled{true};
+#else
+    constexpr bool enabled{false};
+#endif
+
+    enum class Counter : std::size_t
+    {
+        primary_rays,
+        secondary_rays,
+        // Scalar getRayHit calls, by the type of primitive tested.
+        sphere_tests,
+        cuboid_tests,
+        entity_tests,
+        // Primitives tested by the vector kernels, a whole leaf at a time.
+        packed_sphere_tests,
+        packed_cuboid_tests,
+        hits,
+        misses,
+        // Refractor decisions: refracting, reflecting by Schlick's approximation, or reflecting
+        // because the ray cannot refract at all.
+        refractions,
+        reflections,
+        total_internal_reflections,
+        // Calls to Vec3::getRandomUnit and the samples its rejection loop threw away.
+        random_units,
+        random_unit_rejections,
+        // Paths ended early by Russian roulette.
+        roulette_terminations,
+        count,
+    };
+
+    // Paths of this many rays or more share the last bin of the depth histogram.
+    constexpr std::size_t max_histogram_depth{64};
+
+    struct Tally
+    {
+        std::array<std::uint64_t, static_cast<std::size_t>(Counter::count)> counts{};
+        // path_depths[d] counts paths that ended after d rays, either escaping or cut off.
+        std::array<std::uint64_t, max_histogram_depth + 1> path_depths{};
+        // Paths still bouncing when they reached the camera's max_depth.
+        std::uint64_t truncated_paths{0};
+
+        std::uint64_t operator[](const Counter counter) const {return counts[static_cast<std::size_t>(counter)];}
+        Tally& operator+=(const Tally& other);
+    };
+
+    // Wall time, in seconds, of each phase of producing an image.
+    struct PhaseTimes
+    {
+        double render{0.0};
+        double denoise{0.0};
+        double encode{0.0};
+        double write{0.0};
+
+        PhaseTimes& operator+=(const PhaseTimes& other);
+    };
+
+#ifdef RAYTRACER_STATISTICS
+    // A thread's tally, added to the shared total when the thread exits.
+    struct ThreadTally
+    {
+        Tally tally{};
+
+        ThreadTally() = default;
+        ThreadTally(const ThreadTally&) = delete;
+        ThreadTally& operator=(const ThreadTally&) = delete;
+        ~ThreadTally();
+    };
+
+    inline thread_local ThreadTally thread_tally{};
+
+    inline void add(const Counter counter, const std::uint64_t n = 1)
+    {
+        thread_tally.tally.counts[static_cast<std::size_t>(counter)] += n;
+    }
+
+    inline void addPath(const int depth, const bool truncated)
+    {
+        ++thread_tally.tally.path_depths[std::min(static_cast<std::size_t>(depth), max_histogram_depth)];
+        thread_tally.tally.truncated_paths += truncated;
+    }
+
+    // Sums the calling thread's tally and those of every thread that has exited since the last
+    // reset. Worker threads are joined at the end of each render, so call this after it returns.
+    Tally collect();
+    void reset();
+#else
+    inline void add([[maybe_unused]] const Counter counter, [[maybe_unused]] const std::uint64_t n = 1) {}
+    inline void addPath([[maybe_unused]] const int depth, [[maybe_unused]] const bool truncated) {}
+    inline Tally collect() {return Tally{};}
+    inline void reset() {}
+#endif
+
+    // Writes the tallies and phase times as one JSON object.
+    bool writeJSON(const std::string& filepath, const Tally& tally, const PhaseTimes& times);
+}
+
+#endif //RENDERCOUNTERS_H
@@ -0,0 +1,84 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "Utilities.h"
+#include "Vec3.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+// How a sample's random numbers are chosen. Independent samples draw every number from the
+// sample's own PCG32 stream, exactly as renders always have. The others place the first dimensions
+// of each path (where it falls in the pixel, on the lens, in time and its first few bounces) so
+// that a pixel's samples cover them evenly, which lowers the error at a given sample count:
+//
+//     stratified    Jittered strata over each pair of dimensions, sized to the pixel's budget.
+//     sobol         Sobol points, Owen-scrambled and shuffled per pixel (Burley, 2020).
+//     blue_noise    The same Sobol points in every pixel, offset per pixel by a blue-noise mask
+//                   (Heitz and Belcour, 2019), so the error that remains is spread as fine grain.
+enum class SamplerType
+{
+    independent,
+    stratified,
+    sobol,
+    blue_noise,
+};
+
+// The numbers one sample of one pixel draws. Every dimension depends only on the seed, the pixel and
+// the sample index, so renders stay the same whichever thread traces a sample, and shards and
+// resumed renders continue a pixel exactly.
+class Sampler
+{
+public:
+    // Dimensions 0-1 place the sample in the pixel, 2-3 on the lens and 4 in time. Each bounce then
+    // has dimensions_per_bounce of its own, enough for a scattered direction and a choice between
+    // reflecting and refracting. Bounces past max_bounces, and draws a bounce makes beyond its own
+    // dimensions, such as a rejected fuzzy reflection, come from the sample's generator.
+    static constexpr int pixel_dimension{0};
+    static constexpr int lens_dimension{2};
+    static constexpr int time_dimension{4};
+    static constexpr int first_bounce_dimension{5};
+    static constexpr int dimensions_per_bounce{3};
+    static constexpr int max_bounces{8};
+
+    // n_samples is the pixel's budget, which only stratified sampling depends on.
+    Sampler(SamplerType type, std::uint64_t seed, std::uint64_t pixel_index, int pixel_x, int pixel_y, int sample, int n_samples);
+
+    SamplerType getType() const {return type;}
+    // The sample's own stream, stream sample + 1 of the pixel.
+    Random::Generator& getGenerator() {return generator;}
+
+    // Where in the pixel the sample falls, in [0, 1) along each axis.
+    std::array<Real, 2> getPixelSample();
+    // A point in the unit disc, for where the ray leaves the lens.
+    std::array<Real, 2> getLensSample();
+    Real getTimeSample();
+
+    // Moves on to the dimensions of the given bounce of the path.
+    void startBounce(int bounce);
+    Real get1D();
+    std::array<Real, 2> get2D();
+    // A direction uniformly distributed over the unit sphere.
+    Vec3 getUnitVector();
+
+    static const char* getName(SamplerType type);
+    static bool parse(const std::string& name, SamplerType& type);
+
+private:
+    // Two numbers for the pair of dimensions starting at dimension; 1D draws use the first.
+    std::array<Real, 2> getPoint(int dimension) const;
+    bool hasDimensions(int n) const;
+
+    SamplerType type{};
+    Random::Generator generator;
+    std::uint64_t seed{};
+    std::uint64_t pixel_index{};
+    int pixel_x{};
+    int pixel_y{};
+    std::uint32_t sample{};
+    std::uint32_t n_samples{};
+    int dimension{0};
+    int dimension_end{first_bounce_dimension};
+};
+
+#endif //SAMPLER_H
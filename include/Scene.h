@@ -2,44 +2,242 @@
 #define SCENE_H
 
 #include <vector>
+#include "BVH.h"
+#include "Cuboid.h"
+#include "Dynamics.h"
 #include "HittableEntity.h"
 #include "Hit.h"
+#include "PackedPrimitives.h"
+#include "Sphere.h"
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
 
-class Scene {
+class Sampler;
+
+using DynamicsIndex = std::uint32_t;
+// Marks a stored primitive that never moves, so its position is just its centre.
+constexpr DynamicsIndex no_dynamics{std::numeric_limits<DynamicsIndex>::max()};
+
+// Spheres and cuboids as a scene stores them, by value in one array per type. Materials and the
+// dynamics of moving primitives are held once in the scene's tables and referred to by index.
+struct SphereRecord
+{
+    Vec3 centre{};
+    Real radius{};
+    Materials::Index material{};
+    DynamicsIndex dynamics{no_dynamics};
+};
+
+struct CuboidRecord
+{
+    Vec3 centre{};
+    Vec3 half_dimensions{};
+    Materials::Index material{};
+    DynamicsIndex dynamics{no_dynamics};
+};
+
+// How a scene's primitives share its materials.
+struct MaterialReport
+{
+    size_t n_unique{0};
+    size_t n_references{0};
+    // Heap bytes held by the material library, against what giving every primitive its own copy
+    // of its material would take.
+    size_t library_bytes{0};
+    size_t copied_bytes{0};
+};
+
+// The records of one type in a scene. They are either the scene's own, or borrowed in place from
+// memory that a shared owner keeps alive, such as a mapped scene cache; adding to borrowed records
+// first copies them.
+template <typename Record>
+class RecordArray
+{
 public:
-    explicit Scene(const double refractive_index)
-        : refractive_index{refractive_index}
+    RecordArray() = default;
+    RecordArray(const RecordArray&) = delete;
+    RecordArray& operator=(const RecordArray&) = delete;
+    // Moving a vector keeps its buffer, so records still points at the right place afterwards.
+    RecordArray(RecordArray&&) noexcept = default;
+    RecordArray& operator=(RecordArray&&) noexcept = default;
+
+    size_t size() const {return n_records;}
+    const Record& operator[](const size_t index) const {return records[index];}
+    const Record* begin() const {return records;}
+    const Record* end() const {return records + n_records;}
+
+    void push_back(const Record& record)
     {
+        if (owner)
+        {
+            owned.assign(begin(), end());
+            owner.reset();
+        }
+        owned.push_back(record);
+        records = owned.data();
+        n_records = owned.size();
     }
 
-    template <typename T>
-    void add(const T& hittable_entity)
+    void borrow(const std::span<const Record> borrowed, std::shared_ptr<const void> borrowed_owner)
     {
-        static_assert(std::is_base_of_v<HittableEntity, T>, "Can only add subclasses of HittableEntity to scene");
-        entities.push_back(std::make_unique<T>(hittable_entity));
+        owned = std::vector<Record>{};
+        owner = std::move(borrowed_owner);
+        records = borrowed.data();
+        n_records = borrowed.size();
     }
 
+private:
+    std::vector<Record> owned{};
+    std::shared_ptr<const void> owner{};
+    const Record* records{nullptr};
+    size_t n_records{0};
+};
+
+class Scene {
+public:
+    explicit Scene(const double refractive_index)
+        : refractive_index{static_cast<Real>(refractive_index)}
+    {
+    }
+
+    // Spheres and cuboids are flattened into records. Any other entity, including subclasses of
+    // Sphere and Cuboid that may intersect differently, is kept whole.
     template <typename T>
     void add(T&& hittable_entity)
     {
-
-        static_assert(std::is_base_of_v<HittableEntity, T>, "Can only add subclasses of HittableEntity to scene");
-        entities.push_back(std::make_unique<T>(std::forward<T>(hittable_entity)));
+        using Entity = std::remove_cvref_t<T>;
+        static_assert(std::is_base_of_v<HittableEntity, Entity>, "Can only add subclasses of HittableEntity to scene");
+        if constexpr (std::is_same_v<Entity, Sphere>)
+        {
+            addSphere(hittable_entity);
+        }
+        else if constexpr (std::is_same_v<Entity, Cuboid>)
+        {
+            addCuboid(hittable_entity);
+        }
+        else
+        {
+            addEntity(std::make_unique<Entity>(std::forward<T>(hittable_entity)));
+        }
     }
 
+    // Appends records directly, without building an entity first. Their materials and dynamics
+    // must already be in the scene's tables.
+    void addRecord(const SphereRecord& sphere);
+    void addRecord(const CuboidRecord& cuboid);
+    // Uses records held elsewhere, such as in a mapped scene cache, in place of the scene's own.
+    // The owner keeps their memory alive for as long as the scene needs it.
+    void borrowRecords(std::span<const SphereRecord> sphere_records, std::span<const CuboidRecord> cuboid_records, const std::shared_ptr<const void>& owner);
+    // Adds the material or dynamics to the scene's tables, returning the index records refer to it by.
+    Materials::Index addMaterial(const Material& material);
+    DynamicsIndex addDynamics(const Dynamics& primitive_dynamics);
+
+    std::span<const SphereRecord> getSpheres() const {return {spheres.begin(), spheres.size()};}
+    std::span<const CuboidRecord> getCuboids() const {return {cuboids.begin(), cuboids.size()};}
+    // Entities of any other type, each stored whole.
     const std::vector<std::unique_ptr<HittableEntity>>& getHittableEntities() const {return entities;}
-    double getRefractiveIndex() const {return refractive_index;}
+    // Number of primitives of every kind in the scene.
+    size_t size() const {return spheres.size() + cuboids.size() + entities.size();}
+    Real getRefractiveIndex() const {return refractive_index;}
+
+    // Every distinct material used by the scene's entities, each stored once.
+    const std::vector<Material>& getMaterials() const {return materials.getMaterials();}
+    const Material& getMaterial(const Materials::Index index) const {return materials[index];}
+    MaterialReport getMaterialReport() const;
+    size_t getDynamicsCount() const {return dynamics.size();}
+    // The Newtonian entries of the dynamics table; other kinds of dynamics leave theirs empty.
+    const std::vector<std::optional<Newtonian>>& getNewtonianDynamics() const {return newtonian_dynamics;}
 
     Hit getClosestHit(const Ray& ray, const Interval& interval) const;
 
+    // Rebuilds the bounding volume hierarchies over every primitive's extent during the time interval.
+    // Static spheres and cuboids, and moving ones when time slices are enabled, are copied into
+    // packed arrays with hierarchies of their own, whose leaves are tested with the widest vector
+    // kernels the CPU supports.
+    void build();
+
     void setTimeInterval(const Interval& new_interval);
-    void sample();
+    // Draws the time a ray is traced at. The scene itself is never modified while rendering.
+    Real sampleTime(Random::Generator& generator) const;
+    Real sampleTime(Sampler& sampler) const;
+
+    // With n time slices, build() snapshots moving spheres and cuboids at n evenly spaced instants
+    // through the time interval and packs each snapshot like static geometry. Rays are then traced
+    // only at those instants, so motion blur becomes n overlaid exposures. Zero, the default,
+    // evaluates every position at the ray's own time.
+    void setTimeSlices(int n_slices);
+    // True when nothing in the scene moves, so rays are all traced at the start of the interval.
+    bool isStatic() const {return !has_motion;}
 
 
 private:
+    enum class PrimitiveType : std::uint32_t
+    {
+        sphere,
+        cuboid,
+        entity,
+    };
+
+    // A primitive in the hierarchy over everything that is not packed.
+    struct PrimitiveReference
+    {
+        PrimitiveType type{};
+        std::uint32_t index{};
+    };
+
+    // Spheres and cuboids fixed in place, copied in leaf order into packs that vector kernels test.
+    struct PackedGeometry
+    {
+        BVH sphere_bvh{};
+        SpherePack sphere_pack{};
+        BVH cuboid_bvh{};
+        CuboidPack cuboid_pack{};
+    };
+
+    Hit getClosestHitLinear(const Ray& ray, const Interval& interval) const;
+    Hit getRayHit(const SphereRecord& sphere, const Ray& ray, const Interval& interval) const;
+    Hit getRayHit(const CuboidRecord& cuboid, const Ray& ray, const Interval& interval) const;
+    Hit getRayHit(const PrimitiveReference& primitive, const Ray& ray, const Interval& interval) const;
+    // Positions of moving primitives come from the snapshot of a time slice; null for static geometry.
+    Hit getClosestPackedHit(const PackedGeometry& geometry, const Vec3* positions, const Ray& ray, const PackedRay& packed_ray, const Interval& interval) const;
+    void buildPacked(PackedGeometry& geometry, const std::vector<std::uint32_t>& sphere_indices, const std::vector<std::uint32_t>& cuboid_indices, const Vec3* positions) const;
+    void buildTimeSlices(const std::vector<std::uint32_t>& sphere_indices, const std::vector<std::uint32_t>& cuboid_indices);
+    size_t getTimeSlice(Real time) const;
+    Real getSliceTime(size_t slice) const;
+    // The time at the fraction u through the interval, or through its slices.
+    Real getTime(Real u) const;
+    AABB getBoundingBox(const Vec3& centre, DynamicsIndex index, const Interval& time) const;
+    Vec3 getPosition(const Vec3& centre, DynamicsIndex index, Real time) const;
+
+    void addSphere(const Sphere& sphere);
+    void addCuboid(const Cuboid& cuboid);
+    void addEntity(std::unique_ptr<HittableEntity> entity);
+
+    RecordArray<SphereRecord> spheres{};
+    RecordArray<CuboidRecord> cuboids{};
     std::vector<std::unique_ptr<HittableEntity>> entities{};
-    double refractive_index{};
+    std::vector<std::unique_ptr<Dynamics>> dynamics{};
+    // Copies of the Newtonian entries of the dynamics table, evaluated in closed form without a
+    // virtual call. Other kinds of dynamics leave their entry empty.
+    std::vector<std::optional<Newtonian>> newtonian_dynamics{};
+    bool has_motion{false};
+    MaterialLibrary materials{};
+    size_t n_built_primitives{0};
+    BVH bvh{};
+    std::vector<PrimitiveReference> bvh_primitives{};
+    PackedGeometry static_geometry{};
+    int n_time_slices{0};
+    std::vector<PackedGeometry> time_slices{};
+    // Position of every entry of the dynamics table at each time slice, slice by slice.
+    std::vector<Vec3> slice_positions{};
+    PackedKernels::SphereKernel sphere_kernel{PackedKernels::getSphereKernel()};
+    PackedKernels::CuboidKernel cuboid_kernel{PackedKernels::getCuboidKernel()};
+    Real refractive_index{};
     Interval interval{DefinedIntervals::zero};
 };
 
@@ -0,0 +1,56 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include "Camera.h"
+#include "Scene.h"
+#include "Vec3.h"
+#include <string>
+
+// A scene and the camera that views it, as described by a scene file.
+struct SceneDescription
+{
+    CameraConfig config{};
+    Vec3 origin{};
+    Vec3 direction{0.0, 0.0, -1.0};
+    double twist{0.0};
+    Scene scene{1.0};
+
+    Camera makeCamera() const {return Camera{config, origin, direction, twist};}
+};
+
+// Scenes are written as text, one statement per line, with # starting a comment:
+//
+//     camera origin 13 2 3
+//     camera look_at 0 0 0
+//     camera twist 0
+//     camera image_width 1920             Any CameraConfig field, by name.
+//     camera sampler sobol                independent, stratified, sobol or blue_noise.
+//     refractive_index 1.0                Before any material or primitive.
+//     material ground lambertian 0.5 0.5 0.5
+//     material metal reflector 0.7 0.6 0.5 0.1     Albedo, then fuzz.
+//     material glass refractor 1 1 1 1.5           Albedo, then refractive index.
+//     sphere 0 -1000 0 1000 ground                 Centre, radius, material.
+//     cuboid 5 0.2 -1 0.4 0.4 0.4 glass            Centre, dimensions, material.
+//     sphere 4 1 0 0.2 glass newtonian 0 0.5 0 0 -1 0
+//
+// A primitive may end with "newtonian" and its velocity and acceleration, its centre being its
+// position at time zero. Materials must be declared before the primitives that use them.
+//
+// A scene can also be compiled to a binary cache, whose sphere and cuboid records are laid out
+// exactly as a Scene stores them. Loading one maps the file into memory and the scene uses the
+// records where they lie, so nothing is parsed or copied however many primitives there are.
+// Caches hold the machine's native layout and are only read by builds of the same precision.
+namespace SceneFile
+{
+    // Reads either form, telling them apart by the cache's magic number. Problems are reported to
+    // std::clog, with line numbers for text, and leave the description partly filled.
+    bool load(const std::string& filepath, SceneDescription& description);
+    bool readText(const std::string& filepath, SceneDescription& description);
+    bool readCache(const std::string& filepath, SceneDescription& description);
+
+    // Fails for scenes holding entities other than spheres and cuboids, or dynamics other than
+    // Newtonian, which the cache cannot represent.
+    bool writeCache(const std::string& filepath, const SceneDescription& description);
+}
+
+#endif //SCENEFILE_H
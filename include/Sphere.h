@@ -10,11 +10,11 @@ class Sphere : public HittableEntity
 {
 public:
     Sphere(const Vec3& origin, const double radius, const Material& material, const Dynamics& dynamics)
-        : HittableEntity(origin, material, dynamics), radius{radius}
+        : HittableEntity(origin, material, dynamics), radius{static_cast<Real>(radius)}
     {}
 
     Sphere(const Vec3& origin, const double radius, const Material& material)
-        : HittableEntity(origin, material), radius{radius}
+        : HittableEntity(origin, material), radius{static_cast<Real>(radius)}
     {}
 
     Sphere(const Sphere& sphere)
@@ -22,9 +22,16 @@ public:
     {}
 
     Hit getRayHit(const Ray& ray, const Interval& interval) const override;
+    AABB getBoundingBox(const Interval& time) const override;
+
+    // Intersects a sphere of the given radius placed at position. Scenes call this directly on the
+    // spheres they store, without building a Sphere.
+    static Hit getRayHit(const Vec3& position, Real radius, Materials::Index material, const Ray& ray, const Interval& interval);
+
+    Real getRadius() const {return radius;}
 
 private:
-    double radius{};
+    Real radius{};
 };
 
 #endif //SPHERE_H
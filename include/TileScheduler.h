@@ -0,0 +1,82 @@
+#ifndef TILESCHEDULER_H
+#define TILESCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+
+struct Tile
+{
+    int x_min{};
+    int y_min{};
+    int x_max{};
+    int y_max{};
+
+    // Visits each pixel of the tile in Z-order (Morton order), so consecutive pixels stay close
+    // in both directions and share the cache lines of the geometry they hit.
+    template <typename PixelFunction>
+    void forEachPixel(PixelFunction&& pixel_function) const;
+
+    static std::uint32_t compactBits(std::uint32_t x);
+};
+
+// Renders tiles on a pool of threads. Each thread owns a deque seeded with a contiguous run of
+// tiles; it works from the front of its own deque and, once empty, steals from the back of the
+// others, so expensive regions of the image are shared out instead of leaving cores idle.
+class TileScheduler
+{
+public:
+    // report_progress logs how many tiles remain as they finish.
+    TileScheduler(int width, int height, int tile_size, int n_threads, bool report_progress = true);
+
+    // Renders tiles [first_tile, last_tile) of the grid, numbered row by row; a negative
+    // last_tile runs to the end.
+    void run(const std::function<void(const Tile&)>& render_tile, int first_tile = 0, int last_tile = -1) const;
+
+    int getThreadCount() const {return n_threads;}
+    int getTileCount() const {return n_tiles_x*n_tiles_y;}
+    Tile getTile(int index) const;
+
+    static int resolveThreadCount(int requested);
+
+private:
+
+    int width{};
+    int height{};
+    int tile_size{};
+    int n_tiles_x{};
+    int n_tiles_y{};
+    int n_threads{};
+    bool report_progress{true};
+};
+
+inline std::uint32_t Tile::compactBits(std::uint32_t x)
+{
+    x &= 0x55555555u;
+    x = (x ^ (x >> 1u)) & 0x33333333u;
+    x = (x ^ (x >> 2u)) & 0x0f0f0f0fu;
+    x = (x ^ (x >> 4u)) & 0x00ff00ffu;
+    x = (x ^ (x >> 8u)) & 0x0000ffffu;
+    return x;
+}
+
+template <typename PixelFunction>
+void Tile::forEachPixel(PixelFunction&& pixel_function) const
+{
+    // Walk the smallest power-of-two square covering the tile, skipping codes that fall outside.
+    std::uint32_t side{1};
+    while (side < static_cast<std::uint32_t>(x_max - x_min) || side < static_cast<std::uint32_t>(y_max - y_min))
+    {
+        side <<= 1u;
+    }
+    for (std::uint32_t code{0}; code < side*side; ++code)
+    {
+        const int i{x_min + static_cast<int>(compactBits(code))};
+        const int j{y_min + static_cast<int>(compactBits(code >> 1u))};
+        if (i < x_max && j < y_max)
+        {
+            pixel_function(i, j);
+        }
+    }
+}
+
+#endif //TILESCHEDULER_H
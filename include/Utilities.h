@@ -1,18 +1,112 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
+#include <cmath>
+#include <cstdint>
 #include <random>
 #include "Interval.h"
 
 namespace Random
 {
-    static std::uniform_real_distribution distribution(0.0, 1.0);
-    inline std::random_device device{};
-    static std::mt19937 generator{device()};
+    // PCG32 (O'Neill, 2014): a 64-bit LCG whose output is permuted down to 32 bits. Small enough
+    // to live on the stack of every sample, and each odd increment selects an independent stream.
+    class Generator
+    {
+    public:
+        explicit Generator(const std::uint64_t seed, const std::uint64_t stream = 0)
+            : increment{(stream << 1u) | 1u}
+        {
+            next();
+            state += seed;
+            next();
+        }
+
+        std::uint32_t next()
+        {
+            const std::uint64_t old_state{state};
+            state = old_state*6364136223846793005ULL + increment;
+            const auto xor_shifted{static_cast<std::uint32_t>(((old_state >> 18u) ^ old_state) >> 27u)};
+            const auto rotation{static_cast<std::uint32_t>(old_state >> 59u)};
+            return (xor_shifted >> rotation) | (xor_shifted << ((-rotation) & 31u));
+        }
+
+        template <typename T>
+        T getRandom(const IntervalT<T>& interval)
+        {
+            return interval.min + (interval.max - interval.min) * static_cast<T>(std::ldexp(static_cast<double>(next()), -32));
+        }
+
+        Real getRandom()
+        {
+            return getRandom(DefinedIntervals::canonical);
+        }
+
+        // Skips the next n draws in O(log n) steps (Brown, 1994), composing the LCG with itself by squaring.
+        void advance(std::uint64_t n)
+        {
+            std::uint64_t multiplier{6364136223846793005ULL};
+            std::uint64_t step{increment};
+            std::uint64_t total_multiplier{1};
+            std::uint64_t total_step{0};
+            while (n > 0)
+            {
+                if (n & 1u)
+                {
+                    total_multiplier *= multiplier;
+                    total_step = total_step*multiplier + step;
+                }
+                step *= multiplier + 1;
+                multiplier *= multiplier;
+                n >>= 1u;
+            }
+            state = total_multiplier*state + total_step;
+        }
+
+    private:
+        std::uint64_t state{0};
+        std::uint64_t increment{};
+    };
+
+    // SplitMix64 finaliser, used to decorrelate neighbouring counters before they seed a stream.
+    inline std::uint64_t mix(std::uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27u)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31u);
+    }
+
+    // Counter-based seeding: the stream for a sample depends only on the render seed and the
+    // pixel and sample indices, never on which thread traces it. Successive bounces of the path
+    // then draw successive values from that stream.
+    inline Generator getSampleGenerator(const std::uint64_t seed, const std::uint64_t pixel, const std::uint64_t sample)
+    {
+        return Generator{mix(seed ^ mix(pixel)), sample};
+    }
+
+    // For work outside a render, such as building scenes. Each thread has its own generator.
+    inline Generator& getThreadGenerator()
+    {
+        thread_local Generator generator{(static_cast<std::uint64_t>(std::random_device{}()) << 32u) | std::random_device{}()};
+        return generator;
+    }
+
+    // Restarts this thread's generator from a fixed seed, so that scenes built from random draws
+    // can be reproduced exactly.
+    inline void seedThreadGenerator(const std::uint64_t seed)
+    {
+        getThreadGenerator() = Generator{seed};
+    }
+
+    template <typename T>
+    T getRandom(const IntervalT<T>& interval)
+    {
+        return getThreadGenerator().getRandom(interval);
+    }
 
-    inline double getRandom(const Interval& interval = DefinedIntervals::canonical)
+    inline Real getRandom()
     {
-        return interval.min + (interval.max - interval.min) * distribution(generator);
+        return getThreadGenerator().getRandom();
     }
 }
 
@@ -3,49 +3,196 @@
 
 #include <fstream>
 #include <array>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
 #include "Interval.h"
 
-struct Vec3
+namespace Random
 {
-    std::array<double, 3> values{};
+    class Generator;
+}
 
-    double& operator[](int i);
-    double operator[](int i) const;
+// Arithmetic is defined inline so it can be folded into the callers' loops. The arithmetic
+// operators are hidden friends, so scalars of any arithmetic type convert to the component type.
+template <typename T = double>
+struct Vec3T
+{
+    std::array<T, 3> values{};
+
+    constexpr Vec3T() = default;
+
+    // Components may be given in any arithmetic type, so scenes are written once and rounded to
+    // the precision they are rendered in.
+    template <typename X, typename Y, typename Z>
+        requires std::is_arithmetic_v<X> && std::is_arithmetic_v<Y> && std::is_arithmetic_v<Z>
+    constexpr Vec3T(const X x, const Y y, const Z z)
+        : values{static_cast<T>(x), static_cast<T>(y), static_cast<T>(z)}
+    {}
+
+    template <typename U>
+    constexpr explicit Vec3T(const Vec3T<U>& vec)
+        : values{static_cast<T>(vec[0]), static_cast<T>(vec[1]), static_cast<T>(vec[2])}
+    {}
+
+    bool operator==(const Vec3T&) const = default;
+
+    T& operator[](const int i)
+    {
+        return values[static_cast<size_t>(i)];
+    }
+
+    T operator[](const int i) const
+    {
+        return values[static_cast<size_t>(i)];
+    }
+
+    Vec3T operator-() const
+    {
+        return {-values[0], -values[1], -values[2]};
+    }
+
+    Vec3T& operator+=(const Vec3T& vec3)
+    {
+        values[0] += vec3.values[0];
+        values[1] += vec3.values[1];
+        values[2] += vec3.values[2];
+        return *this;
+    }
+
+    Vec3T& operator*=(const T t)
+    {
+        values[0] *= t;
+        values[1] *= t;
+        values[2] *= t;
+        return *this;
+    }
+
+    Vec3T& operator/=(const T t)
+    {
+        return *this *= (1/t);
+    }
+
+    T length() const
+    {
+        return std::sqrt(lengthSquared());
+    }
+
+    T lengthSquared() const
+    {
+        return values[0]*values[0] + values[1]*values[1] + values[2]*values[2];
+    }
 
-    Vec3 operator-() const;
-    Vec3& operator+=(const Vec3& vec3);
-    Vec3& operator*=(double t);
-    Vec3& operator/=(double t);
+    void normalise()
+    {
+        *this /= this->length();
+    }
 
-    double length() const;
-    double lengthSquared() const;
+    Vec3T getNormalised() const
+    {
+        return *this/this->length();
+    }
 
-    void normalise();
+    static Vec3T getNormalised(Vec3T&& vec)
+    {
+        vec /= vec.length();
+        return vec;
+    }
 
-    Vec3 getNormalised() const;
-    static Vec3 getNormalised(Vec3&& vec);
-    Vec3 getAbsolute() const;
+    Vec3T getAbsolute() const
+    {
+        return Vec3T{std::abs(values[0]), std::abs(values[1]), std::abs(values[2])};
+    }
 
-    double dot(const Vec3& vec) const;
-    Vec3 cross(const Vec3& vec) const;
+    T dot(const Vec3T& vec) const
+    {
+        return values[0]*vec[0] + values[1]*vec[1] + values[2]*vec[2];
+    }
 
-    bool isNearZero() const;
+    Vec3T cross(const Vec3T& vec) const
+    {
+        return Vec3T
+        {
+            values[1] * vec[2] - values[2] * vec[1],
+            values[2] * vec[0] - values[0] * vec[2],
+            values[0] * vec[1] - values[1] * vec[0]
+        };
+    }
 
-    static Vec3 getRandom(const Interval& interval = DefinedIntervals::canonical);
-    static Vec3 getRandomUnit();
-    static Vec3 getOnHemisphere(const Vec3& unit_vector, const Vec3& normal);
-    static Vec3 getReflected(const Vec3& vec, const Vec3& normal);
+    bool isNearZero() const
+    {
+        const T limit{static_cast<T>(1e-8)};
+        return std::fabs(values[0]) < limit && std::fabs(values[1]) < limit && std::fabs(values[2]) < limit;
+    }
 
+    static Vec3T getRandom(const IntervalT<T>& interval = IntervalT<T>{0, 1});
+    static Vec3T getRandom(Random::Generator& generator, const IntervalT<T>& interval = IntervalT<T>{0, 1});
+    static Vec3T getRandomUnit(Random::Generator& generator);
+
+    static Vec3T getOnHemisphere(const Vec3T& unit_vector, const Vec3T& normal)
+    {
+        if (unit_vector.dot(normal) > 0)
+        {
+            return unit_vector;
+        }
+        return -unit_vector;
+    }
+
+    static Vec3T getReflected(const Vec3T& vec, const Vec3T& normal)
+    {
+        return vec - 2*vec.dot(normal)*normal;
+    }
+
+    friend Vec3T operator+(const Vec3T& v1, const Vec3T& v2)
+    {
+        return Vec3T{v1[0] + v2[0], v1[1] + v2[1], v1[2] + v2[2]};
+    }
+
+    friend Vec3T operator-(const Vec3T& v1, const Vec3T& v2)
+    {
+        return Vec3T{v1[0] - v2[0], v1[1] - v2[1], v1[2] - v2[2]};
+    }
+
+    friend Vec3T operator*(const Vec3T& v1, const Vec3T& v2)
+    {
+        return Vec3T{v1[0]*v2[0], v1[1]*v2[1], v1[2]*v2[2]};
+    }
+
+    friend Vec3T operator*(const Vec3T& vec3, const T t)
+    {
+        return Vec3T{t*vec3[0], t*vec3[1], t*vec3[2]};
+    }
+
+    friend Vec3T operator*(const T t, const Vec3T& vec3)
+    {
+        return vec3 * t;
+    }
+
+    friend Vec3T operator/(const Vec3T& vec3, const T t)
+    {
+        assert((t !=0) && "Zero division");
+        return vec3 * (1/t);
+    }
+
+    friend Vec3T operator/(const Vec3T& a, const Vec3T& b)
+    {
+        assert((b[0] != 0 && b[1] != 0 && b[2] !=0) && "Zero division");
+        return Vec3T{a[0]/b[0], a[1]/b[1], a[2]/b[2]};
+    }
 };
 
-std::ostream& operator<<(std::ostream& out, const Vec3& vec3);
-void operator<<(std::ofstream& outfile, const Vec3& vec3);
-Vec3 operator+(const Vec3& v1, const Vec3& v2);
-Vec3 operator-(const Vec3& v1, const Vec3& v2);
-Vec3 operator*(const Vec3& v1, const Vec3& v2);
-Vec3 operator*(double t, const Vec3& vec3);
-Vec3 operator*(const Vec3& vec3, double t);
-Vec3 operator/(const Vec3& vec3, double t);
-Vec3 operator/(const Vec3& a, const Vec3& b);
+using Vec3 = Vec3T<Real>;
+
+template <typename T>
+std::ostream& operator<<(std::ostream& out, const Vec3T<T>& vec3)
+{
+    return out << vec3.values[0] << " " << vec3.values[1] << " " << vec3.values[2];
+}
+
+template <typename T>
+void operator<<(std::ofstream& outfile, const Vec3T<T>& vec3)
+{
+    outfile << vec3.values[0] << " " << vec3.values[1] << " " << vec3.values[2];
+}
 
 #endif //VEC3_H
@@ -0,0 +1,54 @@
+#ifndef VIDEOWRITER_H
+#define VIDEOWRITER_H
+
+#include "Vec3.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams frames of linear RGB as one uncompressed YUV4MPEG2 video, ready to pipe into an encoder
+// such as "ffmpeg -i - out.mp4". Frames are gamma corrected as for the PPM encoders and converted to
+// 4:2:0 limited-range BT.601, the colour space encoders assume for Y4M input.
+//
+// Conversion and writing happen on a thread of their own, so the next frame can render meanwhile.
+// At most queue_capacity frames wait to be written; adding another blocks until one has been.
+class Y4MWriter
+{
+public:
+    // Writes to stdout when the filepath is "-".
+    Y4MWriter(const std::string& filepath, int width, int height, double framerate, size_t queue_capacity = 2);
+    // Writes every queued frame before returning.
+    ~Y4MWriter();
+
+    Y4MWriter(const Y4MWriter&) = delete;
+    Y4MWriter& operator=(const Y4MWriter&) = delete;
+
+    void add(std::vector<Vec3> frame);
+
+    static std::string getHeader(int width, int height, double framerate);
+    // Appends one frame, with its "FRAME" marker, to the buffer.
+    static void encode(const std::vector<Vec3>& pixels, int width, int height, std::string& buffer);
+
+private:
+    void writeFrames();
+
+    std::ofstream file{};
+    std::ostream* stream{nullptr};
+    int width{};
+    int height{};
+    size_t queue_capacity{};
+    std::deque<std::vector<Vec3>> frames{};
+    bool finished{false};
+    std::mutex mutex{};
+    std::condition_variable frame_added{};
+    std::condition_variable frame_taken{};
+    std::jthread writer{};
+};
+
+#endif //VIDEOWRITER_H
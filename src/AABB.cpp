@@ -0,0 +1,95 @@
+#include "AABB.h"
+#include "Ray.h"
+#include <algorithm>
+
+AABB AABB::fromPoints(const Vec3& a, const Vec3& b)
+{
+    return AABB{
+        Interval{std::min(a[0], b[0]), std::max(a[0], b[0])},
+        Interval{std::min(a[1], b[1]), std::max(a[1], b[1])},
+        Interval{std::min(a[2], b[2]), std::max(a[2], b[2])}
+    };
+}
+
+const Interval& AABB::axis(const int i) const
+{
+    if (i == 1)
+    {
+        return y;
+    }
+    if (i == 2)
+    {
+        return z;
+    }
+    return x;
+}
+
+int AABB::getLongestAxis() const
+{
+    const Real x_size{x.size()};
+    const Real y_size{y.size()};
+    const Real z_size{z.size()};
+    if (x_size > y_size)
+    {
+        return x_size > z_size ? 0 : 2;
+    }
+    return y_size > z_size ? 1 : 2;
+}
+
+AABB AABB::merge(const AABB& box) const
+{
+    return AABB{x.merge(box.x), y.merge(box.y), z.merge(box.z)};
+}
+
+AABB AABB::merge(const Vec3& point) const
+{
+    return merge(fromPoints(point, point));
+}
+
+AABB AABB::pad(const Vec3& half_extent) const
+{
+    return AABB{
+        Interval{x.min - half_extent[0], x.max + half_extent[0]},
+        Interval{y.min - half_extent[1], y.max + half_extent[1]},
+        Interval{z.min - half_extent[2], z.max + half_extent[2]}
+    };
+}
+
+Vec3 AABB::getCentroid() const
+{
+    return Vec3{(x.min + x.max)/2, (y.min + y.max)/2, (z.min + z.max)/2};
+}
+
+Real AABB::getSurfaceArea() const
+{
+    if (isEmpty())
+    {
+        return 0.0;
+    }
+    const Real dx{x.size()};
+    const Real dy{y.size()};
+    const Real dz{z.size()};
+    return 2*(dx*dy + dy*dz + dz*dx);
+}
+
+bool AABB::isEmpty() const
+{
+    return x.max < x.min || y.max < y.min || z.max < z.min;
+}
+
+bool AABB::isHit(const Ray& ray, const Interval& interval) const
+{
+    // The direction signs pick each slab's near and far faces, as in Cuboid::getRayIntersection.
+    const Vec3& origin{ray.getOrigin()};
+    const Vec3& inverse_direction{ray.getInverseDirection()};
+    Real t_min{interval.min};
+    Real t_max{interval.max};
+    for (int i{0}; i < 3; ++i)
+    {
+        const Interval& slab{axis(i)};
+        const bool negative{ray.getDirectionSign(i) != 0};
+        t_min = std::max(t_min, ((negative ? slab.max : slab.min) - origin[i])*inverse_direction[i]);
+        t_max = std::min(t_max, ((negative ? slab.min : slab.max) - origin[i])*inverse_direction[i]);
+    }
+    return t_min <= t_max;
+}
@@ -0,0 +1,139 @@
+#include "BVH.h"
+#include <algorithm>
+
+namespace
+{
+    // Relative cost of visiting an interior node compared to testing one primitive.
+    constexpr Real traversal_cost{0.125};
+
+    struct Bin
+    {
+        AABB bounds{};
+        size_t count{};
+    };
+
+    size_t getBin(const Real centroid, const Interval& extent)
+    {
+        const Real relative{(centroid - extent.min)/extent.size()};
+        const auto bin{static_cast<size_t>(relative*static_cast<Real>(BVH::n_bins))};
+        return std::min(bin, BVH::n_bins - 1);
+    }
+}
+
+void BVH::build(const std::vector<AABB>& primitive_bounds, const size_t leaf_size)
+{
+    max_leaf_size = std::max(leaf_size, size_t{1});
+    nodes.clear();
+    primitive_indices.clear();
+    if (primitive_bounds.empty())
+    {
+        return;
+    }
+
+    std::vector<BuildPrimitive> primitives{};
+    primitives.reserve(primitive_bounds.size());
+    for (size_t i{0}; i < primitive_bounds.size(); ++i)
+    {
+        const AABB& bounds{primitive_bounds[i]};
+        primitives.push_back(BuildPrimitive{bounds, bounds.getCentroid(), static_cast<std::uint32_t>(i)});
+    }
+
+    // A binary tree over n leaves has at most 2n - 1 nodes.
+    nodes.reserve(2*primitives.size());
+    buildRecursive(primitives, 0, primitives.size(), 0);
+
+    primitive_indices.reserve(primitives.size());
+    for (const BuildPrimitive& primitive : primitives)
+    {
+        primitive_indices.push_back(primitive.index);
+    }
+}
+
+void BVH::makeLeaf(const size_t node_index, const size_t begin, const size_t end)
+{
+    nodes[node_index].offset = static_cast<std::uint32_t>(begin);
+    nodes[node_index].count = static_cast<std::uint32_t>(end - begin);
+}
+
+size_t BVH::buildRecursive(std::vector<BuildPrimitive>& primitives, const size_t begin, const size_t end, const size_t depth)
+{
+    const size_t node_index{nodes.size()};
+    nodes.emplace_back();
+
+    AABB bounds{};
+    AABB centroid_bounds{};
+    for (size_t i{begin}; i < end; ++i)
+    {
+        bounds = bounds.merge(primitives[i].bounds);
+        centroid_bounds = centroid_bounds.merge(primitives[i].centroid);
+    }
+    nodes[node_index].bounds = bounds;
+
+    const size_t count{end - begin};
+    const int axis{centroid_bounds.getLongestAxis()};
+    const Interval& extent{centroid_bounds.axis(axis)};
+    // The traversal stack holds at most one entry per level, so depth is capped to its size.
+    if (count <= max_leaf_size || depth + 1 >= max_depth || extent.size() <= 0)
+    {
+        makeLeaf(node_index, begin, end);
+        return node_index;
+    }
+
+    // Binned surface area heuristic: bucket centroids along the longest axis, then pick the
+    // bucket boundary minimising the expected cost of intersecting both children.
+    std::array<Bin, n_bins> bins{};
+    for (size_t i{begin}; i < end; ++i)
+    {
+        Bin& bin{bins[getBin(primitives[i].centroid[axis], extent)]};
+        bin.bounds = bin.bounds.merge(primitives[i].bounds);
+        bin.count += 1;
+    }
+
+    std::array<Real, n_bins - 1> costs{};
+    AABB left_bounds{};
+    size_t left_count{0};
+    for (size_t i{0}; i < n_bins - 1; ++i)
+    {
+        left_bounds = left_bounds.merge(bins[i].bounds);
+        left_count += bins[i].count;
+        costs[i] = left_bounds.getSurfaceArea()*static_cast<Real>(left_count);
+    }
+    AABB right_bounds{};
+    size_t right_count{0};
+    for (size_t i{n_bins - 1}; i > 0; --i)
+    {
+        right_bounds = right_bounds.merge(bins[i].bounds);
+        right_count += bins[i].count;
+        costs[i - 1] += right_bounds.getSurfaceArea()*static_cast<Real>(right_count);
+    }
+    const size_t best_split{static_cast<size_t>(std::min_element(costs.begin(), costs.end()) - costs.begin())};
+    const Real split_cost{traversal_cost + costs[best_split]/bounds.getSurfaceArea()};
+    if (split_cost >= static_cast<Real>(count) && count <= 4*max_leaf_size)
+    {
+        makeLeaf(node_index, begin, end);
+        return node_index;
+    }
+
+    const auto first{primitives.begin() + static_cast<std::ptrdiff_t>(begin)};
+    const auto last{primitives.begin() + static_cast<std::ptrdiff_t>(end)};
+    auto middle{std::partition(first, last, [&](const BuildPrimitive& primitive)
+    {
+        return getBin(primitive.centroid[axis], extent) <= best_split;
+    })};
+    if (middle == first || middle == last)
+    {
+        // Every centroid fell into one bin; fall back to an equal-count split.
+        middle = first + static_cast<std::ptrdiff_t>(count/2);
+        std::nth_element(first, middle, last, [axis](const BuildPrimitive& a, const BuildPrimitive& b)
+        {
+            return a.centroid[axis] < b.centroid[axis];
+        });
+    }
+    const size_t mid{static_cast<size_t>(middle - primitives.begin())};
+
+    buildRecursive(primitives, begin, mid, depth + 1);
+    const size_t second_child{buildRecursive(primitives, mid, end, depth + 1)};
+    nodes[node_index].offset = static_cast<std::uint32_t>(second_child);
+    nodes[node_index].axis = static_cast<std::uint32_t>(axis);
+    return node_index;
+}
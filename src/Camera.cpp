@@ -1,15 +1,65 @@
-#if defined(USE_OPENMP)
-#include "omp.h"
-#endif
-
 #include "Camera.h"
-#include "PGM.h"
+#include "Checkpoint.h"
+#include "TileScheduler.h"
 #include "Utilities.h"
 #include "Interval.h"
-#include <execution>
+#include "PartialFramebuffer.h"
+#include "VideoWriter.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
 #include <fstream>
 #include <filesystem>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <variant>
+
+namespace
+{
+    // Set by the SIGTERM handler a resumable render installs while it runs.
+    std::atomic<bool> termination_requested{false};
+
+    void requestTermination([[maybe_unused]] const int signal)
+    {
+        termination_requested.store(true);
+    }
+
+    // A 64-bit FNV-1a hash of the bytes of each value added, in order.
+    class Fingerprint
+    {
+    public:
+        template <typename T>
+        void add(const T value)
+        {
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only values without padding are hashed as bytes");
+            std::array<unsigned char, sizeof(T)> bytes{};
+            std::memcpy(bytes.data(), &value, sizeof(T));
+            for (const unsigned char byte : bytes)
+            {
+                hash = (hash ^ byte)*prime;
+            }
+        }
+
+        void add(const Vec3& value)
+        {
+            add(value[0]);
+            add(value[1]);
+            add(value[2]);
+        }
+
+        std::uint64_t get() const {return hash;}
+
+    private:
+        static constexpr std::uint64_t prime{0x100000001b3};
+        std::uint64_t hash{0xcbf29ce484222325};
+    };
+}
 
 Camera::Camera(const CameraConfig& input_config, const Vec3& origin, const Vec3& direction, const double twist)
     : config{input_config}, origin{origin}, direction{direction}, twist{twist}
@@ -45,200 +95,877 @@ void Camera::updateParameters()
 void Camera::deriveCameraParameters()
 {
     image_height = std::max(static_cast<int>(config.image_width/config.aspect_ratio), 1);
-    viewport_width = 2*std::tan(config.field_of_view*M_PI/180.0/2)*config.focus_distance;
-    viewport_height = viewport_width * static_cast<double>(image_height)/config.image_width;
+    viewport_width = static_cast<Real>(2*std::tan(config.field_of_view*M_PI/180.0/2)*config.focus_distance);
+    viewport_height = viewport_width * static_cast<Real>(image_height)/static_cast<Real>(config.image_width);
 }
 
 void Camera::deriveGeometricParameters()
 {
     const double twist_rad{twist*M_PI/180.0};
-    const Vec3 twist_vector{-std::sin(twist_rad),std::cos(twist_rad),0};
+    const Vec3 twist_vector{-std::sin(twist_rad), std::cos(twist_rad), 0};
     viewport_dz = (-direction).getNormalised();
     viewport_dx = twist_vector.cross(viewport_dz).getNormalised();
     viewport_dy = viewport_dz.cross(viewport_dx);
     const Vec3 scaled_viewport_dx{viewport_dx*viewport_width};
     const Vec3 scaled_viewport_dy{-viewport_dy*viewport_height};
-    pixel_dx = scaled_viewport_dx/config.image_width;
-    pixel_dy = scaled_viewport_dy/image_height;
-    viewport_origin = Vec3{origin - config.focus_distance*viewport_dz - scaled_viewport_dx/2 - scaled_viewport_dy/2};
-    pixel_origin = Vec3{viewport_origin + 0.5 * (pixel_dx + pixel_dy)};
-    const double defocus_radius{config.focus_distance*std::tan(config.defocus_angle/2*M_PI/180.0)};
+    pixel_dx = scaled_viewport_dx/static_cast<Real>(config.image_width);
+    pixel_dy = scaled_viewport_dy/static_cast<Real>(image_height);
+    viewport_origin = Vec3{origin - static_cast<Real>(config.focus_distance)*viewport_dz - scaled_viewport_dx/2 - scaled_viewport_dy/2};
+    pixel_origin = Vec3{viewport_origin + (pixel_dx + pixel_dy)/2};
+    const auto defocus_radius{static_cast<Real>(config.focus_distance*std::tan(config.defocus_angle/2*M_PI/180.0))};
     defocus_region_dx = viewport_dx*defocus_radius;
     defocus_region_dy = viewport_dy*defocus_radius;
 }
 
-void Camera::render(Scene& scene, const std::string& filepath, const Interval& interval, const bool parallel) const
+RenderStatistics Camera::render(Scene& scene, const std::string& filepath, const Interval& interval, const bool parallel) const
+{
+    return render(scene, filepath, interval, *ImageWriter::makeEncoder(config.image_format), parallel);
+}
+
+RenderStatistics Camera::render(Scene& scene, const std::string& filepath, const Interval& interval, const ImageEncoder& encoder, const bool parallel) const
+{
+    RenderCounters::reset();
+    RenderCounters::PhaseTimes times{};
+    const RenderStatistics statistics{renderImage(scene, filepath, interval, encoder, parallel, times)};
+    reportCounters(filepath, times);
+    return statistics;
+}
+
+RenderStatistics Camera::render(Scene& scene, const FramebufferView& framebuffer, const Interval& interval, const RenderCallbacks& callbacks, const bool parallel) const
+{
+    if (!framebuffer.hasSize(config.image_width, image_height))
+    {
+        std::clog << "The framebuffer is " << framebuffer.width << "x" << framebuffer.height << " with a stride of " << framebuffer.stride
+                  << " floats, but the image is " << config.image_width << "x" << image_height << ".\n";
+        return {};
+    }
+    if (config.progressive)
+    {
+        const RenderStatistics statistics{renderProgressive(scene, interval, parallel, [&](const std::vector<Vec3>& pixel_colours, const ProgressivePass& pass)
+        {
+            framebuffer.store(pixel_colours);
+            if (callbacks.pass_completed)
+            {
+                callbacks.pass_completed(framebuffer, pass);
+            }
+        })};
+        if (callbacks.frame_completed)
+        {
+            callbacks.frame_completed(framebuffer);
+        }
+        return statistics;
+    }
+    std::vector<Vec3> pixel_colours{};
+    std::vector<int> sample_counts{};
+    std::vector<PixelFeatures> features{};
+    // Each tile is stored by the thread that rendered it, so tiles never write the same pixels.
+    const auto tile_finished{[&](const Tile& tile)
+    {
+        framebuffer.store(pixel_colours, tile);
+        if (callbacks.tile_completed)
+        {
+            callbacks.tile_completed(tile, framebuffer.getRegion(tile));
+        }
+    }};
+    const RenderStatistics statistics{renderFrame(scene, interval, parallel, pixel_colours, sample_counts, {}, config.denoise ? &features : nullptr, tile_finished)};
+    if (config.denoise)
+    {
+        denoiseFrame(pixel_colours, features, parallel);
+        framebuffer.store(pixel_colours);
+    }
+    if (callbacks.frame_completed)
+    {
+        callbacks.frame_completed(framebuffer);
+    }
+    return statistics;
+}
+
+Framebuffer Camera::render(Scene& scene, const Interval& interval, const RenderCallbacks& callbacks, const bool parallel) const
+{
+    Framebuffer framebuffer{config.image_width, image_height};
+    render(scene, framebuffer.getView(), interval, callbacks, parallel);
+    return framebuffer;
+}
+
+RenderStatistics Camera::renderImage(Scene& scene, const std::string& filepath, const Interval& interval, const ImageEncoder& encoder, const bool parallel, RenderCounters::PhaseTimes& times) const
+{
+    if (config.progressive)
+    {
+        // Each pass is written beside the image and moved over it, so a viewer never reads half of one.
+        const std::string pass_path{filepath + ".pass"};
+        double publish_seconds{0.0};
+        // Reported once, as every later pass would most likely fail the same way.
+        bool publish_failed{false};
+        RenderStatistics statistics{renderProgressive(scene, interval, parallel, [&](const std::vector<Vec3>& pixel_colours, const ProgressivePass& pass)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            std::string buffer{};
+            encoder.encode(pixel_colours, config.image_width, image_height, buffer);
+            const auto encoded{std::chrono::steady_clock::now()};
+            ImageWriter::writeBuffer(pass_path, buffer);
+            // A pass that cannot be moved into place is skipped, leaving the render to go on.
+            std::error_code error{};
+            std::filesystem::rename(pass_path, filepath, error);
+            if (error && !publish_failed)
+            {
+                std::clog << "Could not write pass image " << filepath << " (" << error.message() << "); rendering continues.\n";
+                publish_failed = true;
+            }
+            const auto written{std::chrono::steady_clock::now()};
+            times.encode += std::chrono::duration<double>{encoded - start}.count();
+            times.write += std::chrono::duration<double>{written - encoded}.count();
+            publish_seconds += std::chrono::duration<double>{written - start}.count();
+            std::clog << ("Pass " + std::to_string(pass.pass) + ": " + std::to_string(pass.n_samples) + " samples per pixel after "
+                          + std::to_string(pass.seconds) + " s.\n");
+        })};
+        times.render += statistics.seconds - publish_seconds;
+        return statistics;
+    }
+    std::vector<Vec3> pixel_colours{};
+    std::vector<int> sample_counts{};
+    std::vector<PixelFeatures> features{};
+    const bool record_features{config.denoise || config.write_feature_buffers};
+    const RenderStatistics statistics{renderFrame(scene, interval, parallel, pixel_colours, sample_counts, {}, record_features ? &features : nullptr)};
+    times.render += statistics.seconds;
+    times.denoise += denoiseFrame(pixel_colours, features, parallel);
+    const auto start{std::chrono::steady_clock::now()};
+    std::string buffer{};
+    encoder.encode(pixel_colours, config.image_width, image_height, buffer);
+    const auto encoded{std::chrono::steady_clock::now()};
+    ImageWriter::writeBuffer(filepath, buffer);
+    times.encode += std::chrono::duration<double>{encoded - start}.count();
+    times.write += std::chrono::duration<double>{std::chrono::steady_clock::now() - encoded}.count();
+    reportSampleCounts(filepath, sample_counts);
+    writeFeatureBuffers(filepath, features);
+    return statistics;
+}
+
+RenderStatistics Camera::renderShard(Scene& scene, const std::string& filepath, const Interval& interval, const RenderShard& shard) const
+{
+    std::vector<Vec3> pixel_colours{};
+    std::vector<int> sample_counts{};
+    const RenderStatistics statistics{renderFrame(scene, interval, true, pixel_colours, sample_counts, shard)};
+    PartialFramebuffer{config.image_width, image_height, pixel_colours, sample_counts}.write(filepath);
+    return statistics;
+}
+
+RenderStatistics Camera::renderFrame(Scene& scene, const Interval& interval, const bool parallel, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, const RenderShard& shard, std::vector<PixelFeatures>* features, const std::function<void(const Tile&)>& tile_finished) const
+{
+    // Allow user-requested sequential rendering. Otherwise, render in parallel.
+    scene.setTimeInterval(interval);
+    const auto n_pixels{static_cast<size_t>(image_height*config.image_width)};
+    pixel_colours.assign(n_pixels, Vec3{});
+    sample_counts.assign(n_pixels, 0);
+    if (features)
+    {
+        features->assign(n_pixels, PixelFeatures{});
+    }
+    RenderStatistics statistics{};
+    const auto start{std::chrono::steady_clock::now()};
+    if (parallel)
+    {
+        statistics.n_rays = renderParallel(scene, pixel_colours, sample_counts, shard, features, tile_finished);
+    }
+    else
+    {
+        statistics.n_rays = renderSequential(scene, pixel_colours, sample_counts, features, tile_finished);
+    }
+    const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+    statistics.seconds = elapsed.count();
+    for (const int count : sample_counts)
+    {
+        statistics.n_samples += static_cast<std::uint64_t>(count);
+    }
+    return statistics;
+}
+
+RenderStatistics Camera::renderProgressive(Scene& scene, const Interval& interval, const bool parallel, const std::function<void(const std::vector<Vec3>&, const ProgressivePass&)>& pass_finished) const
 {
-    // Allow user-requested sequential rendering. Otherwise, use parallel if possible.
     scene.setTimeInterval(interval);
-    std::ofstream out{filepath};
-    if (!parallel)
+    const auto n_pixels{static_cast<size_t>(image_height*config.image_width)};
+    const auto start{std::chrono::steady_clock::now()};
+    const auto get_elapsed{[&]
     {
-        renderSequential(scene, out);
+        return std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
+    }};
+    const auto out_of_time{[&]
+    {
+        return config.time_budget > 0.0 && get_elapsed() >= config.time_budget;
+    }};
+    const TileScheduler scheduler{config.image_width, image_height, config.tile_size, parallel ? config.threads : 1, false};
+    std::atomic<std::uint64_t> n_rays{0};
+    std::atomic<std::uint64_t> n_traced_samples{0};
+    std::vector<Vec3> pixel_colours(n_pixels);
+
+    // The preview traces the first sample of one pixel in each square and fills the square with it.
+    // Squares are anchored on multiples of the scale, so each is filled by exactly one tile.
+    const int scale{std::max(config.preview_scale, 1)};
+    if (scale > 1)
+    {
+        scheduler.run([&](const Tile& tile)
+        {
+            std::uint64_t n_tile_rays{0};
+            std::uint64_t n_tile_samples{0};
+            for (int j{tile.y_min + (scale - tile.y_min % scale) % scale}; j < tile.y_max; j += scale)
+            {
+                for (int i{tile.x_min + (scale - tile.x_min % scale) % scale}; i < tile.x_max; i += scale)
+                {
+                    const int x_max{std::min(i + scale, config.image_width)};
+                    const int y_max{std::min(j + scale, image_height)};
+                    const int x{(i + x_max - 1)/2};
+                    const int y{(j + y_max - 1)/2};
+                    const Vec3 colour{accumulateSamples(getPixelLocation(x, y), static_cast<std::uint64_t>(x + y*config.image_width), scene, 0, 1, Vec3{}, n_tile_rays)};
+                    ++n_tile_samples;
+                    for (int y_fill{j}; y_fill < y_max; ++y_fill)
+                    {
+                        std::fill_n(pixel_colours.begin() + (i + y_fill*config.image_width), x_max - i, colour);
+                    }
+                }
+            }
+            n_rays.fetch_add(n_tile_rays, std::memory_order_relaxed);
+            n_traced_samples.fetch_add(n_tile_samples, std::memory_order_relaxed);
+        });
+        pass_finished(pixel_colours, ProgressivePass{0, 0, get_elapsed(), std::numeric_limits<double>::infinity(), false});
     }
-    #if defined(USE_OPENMP)
-        renderParallel(scene, out);
-    #else
-        renderSequential(scene);
-    #endif
-    out.close();
+
+    // Each pass traces the next sample of every pixel on the same streams as a fixed-budget render,
+    // adding it to the pixel's sum in the same order, so finishing gives exactly that render's image.
+    // Tiles are skipped once the deadline passes, leaving their pixels a sample behind.
+    std::vector<Vec3> sums(n_pixels);
+    std::vector<int> sample_counts(n_pixels, 0);
+    std::vector<double> luminance_means(n_pixels, 0.0);
+    std::vector<double> luminance_m2s(n_pixels, 0.0);
+    const int n_samples{getSampleBudget()};
+    bool finished{false};
+    for (int sample{0}; !finished; ++sample)
+    {
+        scheduler.run([&](const Tile& tile)
+        {
+            if (out_of_time())
+            {
+                return;
+            }
+            std::uint64_t n_tile_rays{0};
+            tile.forEachPixel([&](const int i, const int j)
+            {
+                const auto pixel_index{static_cast<size_t>(i + j*config.image_width)};
+                const Vec3 colour{accumulateSamples(getPixelLocation(i, j), pixel_index, scene, sample, sample + 1, Vec3{}, n_tile_rays)};
+                sums[pixel_index] += colour;
+                const int count{++sample_counts[pixel_index]};
+                pixel_colours[pixel_index] = sums[pixel_index]/static_cast<Real>(count);
+                const double luminance{0.2126*colour[0] + 0.7152*colour[1] + 0.0722*colour[2]};
+                const double delta{luminance - luminance_means[pixel_index]};
+                luminance_means[pixel_index] += delta/count;
+                luminance_m2s[pixel_index] += delta*(luminance - luminance_means[pixel_index]);
+            });
+            n_rays.fetch_add(n_tile_rays, std::memory_order_relaxed);
+            n_traced_samples.fetch_add(static_cast<std::uint64_t>((tile.x_max - tile.x_min)*(tile.y_max - tile.y_min)), std::memory_order_relaxed);
+        });
+
+        const int fewest_samples{*std::min_element(sample_counts.begin(), sample_counts.end())};
+        double noise{std::numeric_limits<double>::infinity()};
+        if (fewest_samples > 1)
+        {
+            double error_sum{0.0};
+            for (size_t i{0}; i < n_pixels; ++i)
+            {
+                error_sum += getDisplayError(luminance_means[i], luminance_m2s[i], sample_counts[i]);
+            }
+            noise = error_sum/static_cast<double>(n_pixels);
+        }
+        finished = sample + 1 >= n_samples || out_of_time() || (config.target_noise > 0.0 && noise <= config.target_noise);
+        pass_finished(pixel_colours, ProgressivePass{sample + 1, fewest_samples, get_elapsed(), noise, finished});
+    }
+
+    RenderStatistics statistics{};
+    statistics.n_rays = n_rays.load();
+    statistics.n_samples = n_traced_samples.load();
+    statistics.seconds = get_elapsed();
+    return statistics;
 }
 
-void Camera::render(Scene& scene, const std::string& filepath, const double time, const bool parallel) const
+double Camera::denoiseFrame(std::vector<Vec3>& pixel_colours, const std::vector<PixelFeatures>& features, const bool parallel) const
 {
-    render(scene, filepath, Interval{time, time}, parallel);
+    if (!config.denoise || features.empty())
+    {
+        return 0.0;
+    }
+    const auto start{std::chrono::steady_clock::now()};
+    Denoiser::denoise(pixel_colours, features, config.image_width, image_height, config.denoise_iterations, config.tile_size, parallel ? config.threads : 1);
+    return std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
 }
 
-void Camera::renderAnimation(Scene& scene, const std::string& directory, const Interval& interval, const bool motion_blur, const bool parallel, const std::string& filename) const
+void Camera::writeFeatureBuffers(const std::string& filepath, const std::vector<PixelFeatures>& features) const
 {
-    const double frametime{1/config.framerate};
-    const std::filesystem::path folder{directory};
-    std::filesystem::create_directory(folder);
-    const int n_frames{static_cast<int>(std::ceil((interval.max - interval.min)*config.framerate))};
-    double time{interval.min};
-    for (int i{0}; i < n_frames; ++i)
+    if (!config.write_feature_buffers || features.empty())
+    {
+        return;
+    }
+    std::filesystem::path stem{filepath};
+    stem.replace_extension();
+    const std::string extension{ImageWriter::getExtension(config.image_format)};
+    const auto encoder{ImageWriter::makeEncoder(config.image_format)};
+    ImageWriter::write(stem.string() + "_albedo" + extension, Denoiser::getAlbedoImage(features), config.image_width, image_height, *encoder);
+    ImageWriter::write(stem.string() + "_normal" + extension, Denoiser::getNormalImage(features), config.image_width, image_height, *encoder);
+    ImageWriter::writeGreyscale(stem.string() + "_depth.pgm", Denoiser::getDepthImage(features), config.image_width, image_height);
+}
+
+void Camera::reportSampleCounts(const std::string& filepath, const std::vector<int>& sample_counts) const
+{
+    if (!config.adaptive_sampling)
     {
-        const std::filesystem::path path{folder/(filename + std::to_string(i) + ".ppm")};
-        if (motion_blur)
+        return;
+    }
+    long long n_samples{0};
+    int most_samples{1};
+    for (const int count : sample_counts)
+    {
+        n_samples += count;
+        most_samples = std::max(most_samples, count);
+    }
+    std::clog << "Adaptive sampling traced " << n_samples << " samples, "
+              << static_cast<double>(n_samples)/static_cast<double>(sample_counts.size()) << " per pixel.\n";
+    if (config.write_sample_map)
+    {
+        std::vector<double> sample_map(sample_counts.size());
+        for (size_t i{0}; i < sample_counts.size(); ++i)
         {
-            render(scene, path, Interval{time, std::min(interval.max, time + frametime)});
+            sample_map[i] = static_cast<double>(sample_counts[i])/most_samples;
         }
-        else
+        std::filesystem::path map_path{filepath};
+        map_path.replace_extension();
+        ImageWriter::writeGreyscale(map_path.string() + "_samples.pgm", sample_map, config.image_width, image_height);
+    }
+}
+
+void Camera::reportCounters(const std::string& filepath, const RenderCounters::PhaseTimes& times) const
+{
+    if constexpr (RenderCounters::enabled)
+    {
+        std::filesystem::path stats_path{filepath};
+        stats_path.replace_extension();
+        stats_path += "_stats.json";
+        if (RenderCounters::writeJSON(stats_path.string(), RenderCounters::collect(), times))
         {
-            render(scene, path, time, parallel);
+            std::clog << "Wrote render statistics to " << stats_path.string() << ".\n";
         }
+    }
+}
+
+RenderStatistics Camera::render(Scene& scene, const std::string& filepath, const Real time, const bool parallel) const
+{
+    return render(scene, filepath, Interval{time, time}, parallel);
+}
+
+template <typename FrameFunction>
+void Camera::forEachFrame(const Interval& interval, const bool motion_blur, FrameFunction&& render_frame) const
+{
+    const auto frametime{static_cast<Real>(1/config.framerate)};
+    const int n_frames{static_cast<int>(std::ceil((interval.max - interval.min)*config.framerate))};
+    Real time{interval.min};
+    for (int i{0}; i < n_frames; ++i)
+    {
+        render_frame(i, motion_blur ? Interval{time, std::min(interval.max, time + frametime)} : Interval{time, time});
         time += frametime;
     }
 }
 
-void Camera::renderParallel(Scene& scene, std::ofstream& file) const
+void Camera::renderAnimation(Scene& scene, const std::string& directory, const Interval& interval, const bool motion_blur, const bool parallel, const std::string& filename) const
+{
+    const std::filesystem::path folder{directory};
+    std::filesystem::create_directory(folder);
+    const auto encoder{ImageWriter::makeEncoder(config.image_format)};
+    RenderCounters::reset();
+    RenderCounters::PhaseTimes times{};
+    forEachFrame(interval, motion_blur, [&](const int i, const Interval& frame_interval)
+    {
+        const std::filesystem::path path{folder/(filename + std::to_string(i) + ImageWriter::getExtension(config.image_format))};
+        renderImage(scene, path, frame_interval, *encoder, parallel, times);
+    });
+    reportCounters(folder/filename, times);
+}
+
+void Camera::renderVideo(Scene& scene, const std::string& filepath, const Interval& interval, const bool motion_blur, const bool parallel) const
 {
-    int n_rows{image_height};
-    std::clog << "Rendering rows. Remaining: " << n_rows << "\n";
-    std::vector<Vec3> pixel_colours(static_cast<size_t>(image_height*config.image_width));
-    int j{};
-    #pragma omp parallel for
-    for (j = 0; j < image_height; ++j)
+    Y4MWriter writer{filepath, config.image_width, image_height, config.framerate};
+    forEachFrame(interval, motion_blur, [&](const int i, const Interval& frame_interval)
     {
-        for (int i{0}; i < config.image_width; ++i)
+        std::clog << "Rendering frame " << i << ".\n";
+        std::vector<Vec3> pixel_colours{};
+        std::vector<int> sample_counts{};
+        std::vector<PixelFeatures> features{};
+        renderFrame(scene, frame_interval, parallel, pixel_colours, sample_counts, {}, config.denoise ? &features : nullptr);
+        denoiseFrame(pixel_colours, features, parallel);
+        writer.add(std::move(pixel_colours));
+    });
+}
+
+ResumableRender Camera::renderResumable(Scene& scene, const std::string& filepath, const Interval& interval, const CheckpointConfig& checkpoint) const
+{
+    scene.setTimeInterval(interval);
+    const auto n_pixels{static_cast<size_t>(image_height*config.image_width)};
+    std::vector<Vec3> sums(n_pixels);
+    std::vector<int> sample_counts(n_pixels);
+    const Checkpoint::Identity identity{config.image_width, image_height, config.seed, config.sampler, getFingerprint(scene, interval)};
+    const Checkpoint::Status status{Checkpoint::read(checkpoint.filepath, identity, sums, sample_counts)};
+    if (status == Checkpoint::Status::mismatched)
+    {
+        // Its samples could not be mixed with this render's, and starting afresh would overwrite it.
+        std::clog << "Checkpoint " << checkpoint.filepath << " was saved by a different render, so it cannot be resumed.\n";
+        return {status};
+    }
+    if (status == Checkpoint::Status::resumed)
+    {
+        std::clog << "Resuming from checkpoint " << checkpoint.filepath << ".\n";
+    }
+
+    // Tiles publish finished pixels under the lock, so a save never sees a tile half done.
+    std::mutex mutex{};
+    const auto save{[&]
+    {
+        std::vector<Vec3> saved_sums{};
+        std::vector<int> saved_counts{};
+        {
+            const std::lock_guard lock{mutex};
+            saved_sums = sums;
+            saved_counts = sample_counts;
+        }
+        if (Checkpoint::write(checkpoint.filepath, identity, saved_sums, saved_counts))
+        {
+            std::clog << "Saved checkpoint " << checkpoint.filepath << ".\n";
+        }
+    }};
+
+    termination_requested.store(false);
+    const auto previous_handler{std::signal(SIGTERM, requestTermination)};
+    std::atomic<bool> finished{false};
+    std::jthread saver{[&]
+    {
+        auto last_save{std::chrono::steady_clock::now()};
+        while (!finished.load() && !termination_requested.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            if (std::chrono::duration<double>{std::chrono::steady_clock::now() - last_save}.count() >= checkpoint.interval)
+            {
+                save();
+                last_save = std::chrono::steady_clock::now();
+            }
+        }
+    }};
+
+    const int n_samples{config.anti_aliasing_samples + 1};
+    RenderStatistics statistics{};
+    std::atomic<std::uint64_t> n_rays{0};
+    std::atomic<std::uint64_t> n_traced_samples{0};
+    const auto start{std::chrono::steady_clock::now()};
+    const TileScheduler scheduler{config.image_width, image_height, config.tile_size, config.threads};
+    scheduler.run([&](const Tile& tile)
+    {
+        if (termination_requested.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        // Only this tile writes its pixels, so it can read their progress without the lock.
+        struct FinishedPixel
         {
-            Vec3 pixel_location{pixel_origin + (i * pixel_dx) + (j * pixel_dy)};
-            pixel_colours[static_cast<size_t>(i + j*config.image_width)] = {colourPixel(pixel_location, scene)};
+            size_t index{};
+            Vec3 sum{};
+            int n_samples{};
+        };
+        std::vector<FinishedPixel> finished_pixels{};
+        std::uint64_t n_tile_rays{0};
+        std::uint64_t n_tile_samples{0};
+        tile.forEachPixel([&](const int i, const int j)
+        {
+            const auto pixel_index{static_cast<size_t>(i + j*config.image_width)};
+            const int n_done{sample_counts[pixel_index]};
+            if (config.adaptive_sampling)
+            {
+                // Adaptive pixels choose their own sample counts, so they are only ever finished whole.
+                if (n_done == 0)
+                {
+                    int n_pixel_samples{0};
+                    const Vec3 mean{colourPixelAdaptive(getPixelLocation(i, j), pixel_index, scene, n_pixel_samples, n_tile_rays)};
+                    finished_pixels.push_back({pixel_index, mean*static_cast<Real>(n_pixel_samples), n_pixel_samples});
+                    n_tile_samples += static_cast<std::uint64_t>(n_pixel_samples);
+                }
+                return;
+            }
+            if (n_done < n_samples)
+            {
+                const Vec3 sum{accumulateSamples(getPixelLocation(i, j), pixel_index, scene, n_done, n_samples, sums[pixel_index], n_tile_rays)};
+                finished_pixels.push_back({pixel_index, sum, n_samples});
+                n_tile_samples += static_cast<std::uint64_t>(n_samples - n_done);
+            }
+        });
+        {
+            const std::lock_guard lock{mutex};
+            for (const FinishedPixel& pixel : finished_pixels)
+            {
+                sums[pixel.index] = pixel.sum;
+                sample_counts[pixel.index] = pixel.n_samples;
+            }
         }
-        std::clog << "Rendering rows. Remaining: " << n_rows << "\n";
-        n_rows -= 1;
+        n_rays.fetch_add(n_tile_rays, std::memory_order_relaxed);
+        n_traced_samples.fetch_add(n_tile_samples, std::memory_order_relaxed);
+    });
+    const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+    finished.store(true);
+    saver.join();
+    std::signal(SIGTERM, previous_handler);
+    statistics.n_rays = n_rays.load();
+    statistics.n_samples = n_traced_samples.load();
+    statistics.seconds = elapsed.count();
+
+    // The final checkpoint lets a later render with a larger budget top this one up.
+    save();
+    if (termination_requested.load())
+    {
+        std::clog << "Rendering interrupted. Progress is saved in " << checkpoint.filepath << ".\n";
+        std::raise(SIGTERM);
+        return {status, statistics};
     }
-    PGM::writeHeader(file, config.image_width, image_height);
-    for (const Vec3& pixel_colour : pixel_colours)
+    std::clog << "Rendering complete.\n";
+    std::vector<Vec3> pixel_colours(n_pixels);
+    for (size_t i{0}; i < n_pixels; ++i)
     {
-        PGM::writeRGBTriple(file, pixel_colour);
+        pixel_colours[i] = sample_counts[i] > 0 ? sums[i]/static_cast<Real>(sample_counts[i]) : Vec3{};
     }
+    ImageWriter::write(filepath, pixel_colours, config.image_width, image_height, *ImageWriter::makeEncoder(config.image_format));
+    reportSampleCounts(filepath, sample_counts);
+    return {status, statistics};
+}
 
-    // I wanted to try a native C++ implementation but this wouldn't run in parallel on my Mac,
-    // neither with g++ or AppleClang. Might revisit this later.
-    /*
-    std::vector<Vec3> pixel_colours(image_height*config.image_width);
-    std::transform(
-        std::execution::par_unseq,
-        pixel_locations.begin(),
-        pixel_locations.end(),
-        pixel_colours.begin(),
-            [this, scene](const Vec3& pixel_location) -> Vec3
-            {
-                std::clog << "Rendering pixel.\n";
-                return this->colourPixel(pixel_location, scene);
-            });
-    */
+Vec3 Camera::getPixelLocation(const int i, const int j) const
+{
+    return pixel_origin + (static_cast<Real>(i) * pixel_dx) + (static_cast<Real>(j) * pixel_dy);
 }
 
-void Camera::renderSequential(Scene& scene, std::ofstream& file) const
+std::uint64_t Camera::renderPixel(const int i, const int j, const Scene& scene, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, const RenderShard& shard, std::vector<PixelFeatures>* features) const
 {
-    PGM::writeHeader(file, config.image_width, image_height);
+    const Vec3 pixel_location{getPixelLocation(i, j)};
+    const auto pixel_index{static_cast<size_t>(i + j*config.image_width)};
+    PixelFeatures* const pixel_features{features ? &(*features)[pixel_index] : nullptr};
+    std::uint64_t n_rays{0};
+    if (config.adaptive_sampling)
+    {
+        pixel_colours[pixel_index] = colourPixelAdaptive(pixel_location, pixel_index, scene, sample_counts[pixel_index], n_rays, pixel_features);
+        return n_rays;
+    }
+    const int n_samples{config.anti_aliasing_samples + 1};
+    const int last_sample{shard.last_sample < 0 ? n_samples : std::min(shard.last_sample, n_samples)};
+    const int first_sample{std::clamp(shard.first_sample, 0, last_sample)};
+    const Vec3 sum{accumulateSamples(pixel_location, pixel_index, scene, first_sample, last_sample, Vec3{}, n_rays, pixel_features)};
+    sample_counts[pixel_index] = last_sample - first_sample;
+    pixel_colours[pixel_index] = sample_counts[pixel_index] > 0 ? sum/static_cast<Real>(sample_counts[pixel_index]) : Vec3{};
+    return n_rays;
+}
+
+std::uint64_t Camera::renderParallel(const Scene& scene, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, const RenderShard& shard, std::vector<PixelFeatures>* features, const std::function<void(const Tile&)>& tile_finished) const
+{
+    // Rays are tallied per tile and published once, so the shared counter is touched rarely.
+    std::atomic<std::uint64_t> n_rays{0};
+    const TileScheduler scheduler{config.image_width, image_height, config.tile_size, config.threads};
+    scheduler.run([&](const Tile& tile)
+    {
+        std::uint64_t n_tile_rays{0};
+        tile.forEachPixel([&](const int i, const int j)
+        {
+            n_tile_rays += renderPixel(i, j, scene, pixel_colours, sample_counts, shard, features);
+        });
+        n_rays.fetch_add(n_tile_rays, std::memory_order_relaxed);
+        if (tile_finished)
+        {
+            tile_finished(tile);
+        }
+    }, shard.first_tile, shard.last_tile);
+    std::clog << "Rendering complete.\n";
+    return n_rays.load();
+}
+
+std::uint64_t Camera::renderSequential(const Scene& scene, std::vector<Vec3>& pixel_colours, std::vector<int>& sample_counts, std::vector<PixelFeatures>* features, const std::function<void(const Tile&)>& tile_finished) const
+{
+    std::uint64_t n_rays{0};
     for (int j{0}; j < image_height; ++j)
     {
         std::clog << "Rendering. Rows remaining: " << image_height - j << " " << std::endl;
         for (int i{0}; i < config.image_width; ++i)
         {
-            const Vec3 pixel_location {pixel_origin + (i * pixel_dx) + (j * pixel_dy)};
-            const Vec3 pixel_colour {colourPixel(pixel_location, scene)};
-            PGM::writeRGBTriple(file, pixel_colour);
+            n_rays += renderPixel(i, j, scene, pixel_colours, sample_counts, {}, features);
+        }
+        if (tile_finished)
+        {
+            tile_finished(Tile{0, j, config.image_width, j + 1});
         }
     }
     std::clog << "Rendering complete.\n";
+    return n_rays;
 }
 
-std::vector<Vec3> Camera::samplePixel(const Vec3& pixel_location) const
+std::uint64_t Camera::getFingerprint(const Scene& scene, const Interval& interval) const
 {
-    std::vector<Vec3> subpixel_locations{};
-    subpixel_locations.push_back(pixel_location);
-    for (int i{0}; i < config.anti_aliasing_samples; ++i)
+    Fingerprint fingerprint{};
+    for (const Vec3& geometry : {origin, pixel_origin, pixel_dx, pixel_dy, defocus_region_dx, defocus_region_dy})
     {
-        const Vec3 random_subpixel {getRandomSubpixel(pixel_location)};
-        subpixel_locations.push_back(random_subpixel);
+        fingerprint.add(geometry);
+    }
+    fingerprint.add(interval.min);
+    fingerprint.add(interval.max);
+    fingerprint.add(config.max_depth);
+    fingerprint.add(config.russian_roulette);
+    fingerprint.add(config.roulette_min_depth);
+    fingerprint.add(config.adaptive_sampling);
+    if (config.adaptive_sampling)
+    {
+        fingerprint.add(config.min_samples);
+        fingerprint.add(config.noise_threshold);
+    }
+    // Otherwise a pixel's samples are the same whatever its budget, which lets a later render with
+    // a larger budget top up this one's pixels.
+    if (config.adaptive_sampling || config.sampler == SamplerType::stratified)
+    {
+        fingerprint.add(getSampleBudget());
     }
-    return subpixel_locations;
-}
 
-Vec3 Camera::sampleOrigin() const
-{
-    while (true)
+    fingerprint.add(scene.getRefractiveIndex());
+    fingerprint.add(scene.getMaterials().size());
+    // Parameters go in as their bytes, since std::hash may change with the standard library while
+    // the fingerprint is kept on disk.
+    for (const Material& material : scene.getMaterials())
     {
-        const Vec3 point_in_unit_disc
+        fingerprint.add(material.index());
+        std::visit([&fingerprint](const auto& parameters)
         {
-            Random::getRandom(DefinedIntervals::unit),
-            Random::getRandom(DefinedIntervals::unit),
-            0.0
-        };
-        if (point_in_unit_disc.lengthSquared() < 1)
+            using Parameters = std::decay_t<decltype(parameters)>;
+            fingerprint.add(parameters.albedo);
+            if constexpr (std::is_same_v<Parameters, Reflector>)
+            {
+                fingerprint.add(parameters.fuzz);
+            }
+            else if constexpr (std::is_same_v<Parameters, Refractor>)
+            {
+                fingerprint.add(parameters.refractive_index);
+            }
+        }, material);
+    }
+    fingerprint.add(scene.getNewtonianDynamics().size());
+    for (const std::optional<Newtonian>& newtonian : scene.getNewtonianDynamics())
+    {
+        fingerprint.add(newtonian.has_value());
+        if (newtonian)
         {
-            return origin + point_in_unit_disc[0] * defocus_region_dx + point_in_unit_disc[1] * defocus_region_dy;
+            fingerprint.add(newtonian->getPosition());
+            fingerprint.add(newtonian->getVelocity());
+            fingerprint.add(newtonian->getAcceleration());
         }
     }
+    fingerprint.add(scene.getSpheres().size());
+    for (const SphereRecord& sphere : scene.getSpheres())
+    {
+        fingerprint.add(sphere.centre);
+        fingerprint.add(sphere.radius);
+        fingerprint.add(sphere.material);
+        fingerprint.add(sphere.dynamics);
+    }
+    fingerprint.add(scene.getCuboids().size());
+    for (const CuboidRecord& cuboid : scene.getCuboids())
+    {
+        fingerprint.add(cuboid.centre);
+        fingerprint.add(cuboid.half_dimensions);
+        fingerprint.add(cuboid.material);
+        fingerprint.add(cuboid.dynamics);
+    }
+    // Other entities are only known by where they lie over the render's interval.
+    fingerprint.add(scene.getHittableEntities().size());
+    for (const std::unique_ptr<HittableEntity>& entity : scene.getHittableEntities())
+    {
+        const AABB box{entity->getBoundingBox(interval)};
+        for (int axis{0}; axis < 3; ++axis)
+        {
+            fingerprint.add(box.axis(axis).min);
+            fingerprint.add(box.axis(axis).max);
+        }
+    }
+    return fingerprint.get();
+}
+
+int Camera::getSampleBudget() const
+{
+    if (config.adaptive_sampling)
+    {
+        return std::max(config.max_samples, std::max(config.min_samples, 2));
+    }
+    return config.anti_aliasing_samples + 1;
+}
+
+Sampler Camera::makeSampler(const std::uint64_t pixel_index, const int sample) const
+{
+    const auto width{static_cast<std::uint64_t>(config.image_width)};
+    return Sampler{config.sampler, config.seed, pixel_index, static_cast<int>(pixel_index % width), static_cast<int>(pixel_index / width), sample, getSampleBudget()};
+}
+
+Vec3 Camera::getSubpixel(const Vec3& pixel_location, const int sample, Sampler& sampler, Random::Generator& pixel_generator) const
+{
+    // Independent samples keep their own placement, drawn from the pixel's stream 0.
+    if (sampler.getType() == SamplerType::independent)
+    {
+        return sample == 0 ? pixel_location : getRandomSubpixel(pixel_location, pixel_generator);
+    }
+    const auto [u, v]{sampler.getPixelSample()};
+    return pixel_location + (u - Real{0.5})*pixel_dx + (v - Real{0.5})*pixel_dy;
 }
 
-Vec3 Camera::colourSubpixel(const Vec3& subpixel_location, Scene& scene) const
+Vec3 Camera::colourSubpixel(const Vec3& subpixel_location, const Scene& scene, Sampler& sampler, std::uint64_t& n_rays, SampleFeatures* const features) const
 {
-    const Vec3 ray_origin{sampleOrigin()};
-    scene.sample();
-    Ray ray_to_pixel{ray_origin, subpixel_location - ray_origin, scene.getRefractiveIndex()};
-    return ray_colour(ray_to_pixel, scene);
+    const auto [lens_x, lens_y]{sampler.getLensSample()};
+    const Vec3 ray_origin{origin + lens_x*defocus_region_dx + lens_y*defocus_region_dy};
+    const Real time{scene.sampleTime(sampler)};
+    Ray ray_to_pixel{ray_origin, subpixel_location - ray_origin, scene.getRefractiveIndex(), time};
+    return ray_colour(ray_to_pixel, scene, sampler, n_rays, features);
 }
 
-Vec3 Camera::colourPixel(const Vec3& pixel_location, Scene& scene) const
+Vec3 Camera::accumulateSamples(const Vec3& pixel_location, const std::uint64_t pixel_index, const Scene& scene, const int first_sample, const int last_sample, Vec3 sum, std::uint64_t& n_rays, PixelFeatures* const features) const
 {
-    Vec3 colour{};
-    const std::vector<Vec3> subpixel_locations {samplePixel(pixel_location)};
-    for (const Vec3& subpixel_location : subpixel_locations)
+    // With independent sampling, stream 0 of each pixel places its subpixels; sample n then traces
+    // its path on stream n + 1. Every draw therefore depends only on the seed and pixel, whichever
+    // thread renders it. The first sample goes through the pixel centre, and the rest are jittered
+    // as they are traced. Other samplers place every subpixel from the sample's own dimensions.
+    Random::Generator pixel_generator{Random::getSampleGenerator(config.seed, pixel_index, 0)};
+    // Each jittered sample takes two draws, so starting later skips those of the earlier samples.
+    if (first_sample > 1 && config.sampler == SamplerType::independent)
+    {
+        pixel_generator.advance(2*static_cast<std::uint64_t>(first_sample - 1));
+    }
+    for (int sample{first_sample}; sample < last_sample; ++sample)
     {
-        colour += colourSubpixel(subpixel_location, scene);
+        Sampler sampler{makeSampler(pixel_index, sample)};
+        const Vec3 subpixel_location{getSubpixel(pixel_location, sample, sampler, pixel_generator)};
+        SampleFeatures sample_features{};
+        const Vec3 colour{colourSubpixel(subpixel_location, scene, sampler, n_rays, features ? &sample_features : nullptr)};
+        sum += colour;
+        if (features)
+        {
+            features->add(sample_features, colour);
+        }
     }
-    return colour / static_cast<double>(subpixel_locations.size());
+    return sum;
 }
 
-Vec3 Camera::getRandomSubpixel(const Vec3& pixel_location) const
+Vec3 Camera::colourPixelAdaptive(const Vec3& pixel_location, const std::uint64_t pixel_index, const Scene& scene, int& n_samples, std::uint64_t& n_rays, PixelFeatures* const features) const
 {
-    Vec3 random_multiplier{Random::getRandom(DefinedIntervals::random_pixel), Random::getRandom(DefinedIntervals::random_pixel), 0};
+    // Samples use the same streams as accumulateSamples, so an adaptive pixel that runs to
+    // anti_aliasing_samples + 1 samples matches the fixed-budget result exactly.
+    Random::Generator pixel_generator{Random::getSampleGenerator(config.seed, pixel_index, 0)};
+    const int min_samples{std::max(config.min_samples, 2)};
+    const int max_samples{getSampleBudget()};
+    Vec3 mean{};
+    double luminance_mean{0.0};
+    double luminance_m2{0.0};
+    int sample{0};
+    while (sample < max_samples)
+    {
+        Sampler sampler{makeSampler(pixel_index, sample)};
+        const Vec3 subpixel_location{getSubpixel(pixel_location, sample, sampler, pixel_generator)};
+        SampleFeatures sample_features{};
+        const Vec3 colour{colourSubpixel(subpixel_location, scene, sampler, n_rays, features ? &sample_features : nullptr)};
+        if (features)
+        {
+            features->add(sample_features, colour);
+        }
+        ++sample;
+
+        // Welford's update keeps the running mean and variance stable in a single pass.
+        mean += (colour - mean)/static_cast<Real>(sample);
+        const double luminance{0.2126*colour[0] + 0.7152*colour[1] + 0.0722*colour[2]};
+        const double delta{luminance - luminance_mean};
+        luminance_mean += delta/sample;
+        luminance_m2 += delta*(luminance - luminance_mean);
+        if (sample >= min_samples && isConverged(luminance_mean, luminance_m2, sample))
+        {
+            break;
+        }
+    }
+    n_samples = sample;
+    return mean;
+}
+
+bool Camera::isConverged(const double luminance_mean, const double luminance_m2, const int n_samples) const
+{
+    return getDisplayError(luminance_mean, luminance_m2, n_samples) <= config.noise_threshold;
+}
+
+double Camera::getDisplayError(const double luminance_mean, const double luminance_m2, const int n_samples)
+{
+    // The output is gamma corrected with a square root, so an error dL in the linear mean shows up
+    // as roughly dL/(2 sqrt(L)) on screen; dark pixels need proportionally tighter estimates.
+    const double variance{luminance_m2/(n_samples - 1)};
+    const double standard_error{std::sqrt(variance/n_samples)};
+    return standard_error/(2.0*std::sqrt(std::max(luminance_mean, 1e-4)));
+}
+
+Vec3 Camera::getRandomSubpixel(const Vec3& pixel_location, Random::Generator& generator) const
+{
+    Vec3 random_multiplier{generator.getRandom(DefinedIntervals::random_pixel), generator.getRandom(DefinedIntervals::random_pixel), 0};
     return pixel_location + random_multiplier*(pixel_dx + pixel_dy);
 }
 
-Vec3 Camera::ray_colour(Ray& ray, const Scene& scene) const
+Vec3 Camera::ray_colour(Ray& ray, const Scene& scene, Sampler& sampler, std::uint64_t& n_rays, SampleFeatures* const features) const
 {
     Vec3 attenuation{1,1,1};
+    // Features are taken where the path first meets a diffuse surface. Mirrors and glass only tint
+    // what lies beyond them, so until then each hit is recorded provisionally and the path's
+    // tint and length carried on.
+    bool recording_features{features != nullptr};
+    Vec3 feature_tint{1,1,1};
+    Real feature_depth{0};
     for (int i{0}; i < config.max_depth; ++i)
     {
-        const Hit hit{scene.getClosestHit(ray, Interval(0.001, Constants::infinity))};
+        ++n_rays;
+        RenderCounters::add(i == 0 ? RenderCounters::Counter::primary_rays : RenderCounters::Counter::secondary_rays);
+        const Hit hit{scene.getClosestHit(ray, Interval{Precision::ray_epsilon, Constants::infinity})};
+        if (recording_features)
+        {
+            if (hit)
+            {
+                const Material& material{scene.getMaterial(hit.material)};
+                feature_tint = feature_tint*Materials::getAlbedo(material);
+                feature_depth += (hit.point - ray.getOrigin()).length();
+                *features = SampleFeatures{feature_tint, hit.normal, feature_depth};
+                recording_features = !std::holds_alternative<Lambertian>(material);
+            }
+            else
+            {
+                *features = SampleFeatures{feature_tint*background_colour(ray), -ray.getUnitDirection(), feature_depth};
+            }
+        }
         if (!hit)
         {
+            RenderCounters::add(RenderCounters::Counter::misses);
+            RenderCounters::addPath(i + 1, false);
             return attenuation*background_colour(ray);
         }
-        attenuation = attenuation * hit.material->attenuate(ray, hit.point, hit.normal);
+        RenderCounters::add(RenderCounters::Counter::hits);
+        sampler.startBounce(i);
+        attenuation = attenuation * Materials::attenuate(scene.getMaterial(hit.material), ray, hit.point, hit.normal, sampler);
+        if (config.russian_roulette && i + 1 >= config.roulette_min_depth)
+        {
+            const Real survival{std::min<Real>(std::max({attenuation[0], attenuation[1], attenuation[2]}), 1)};
+            // Roulette only decides how long a path runs, so it draws from the generator whatever the sampler.
+            if (sampler.getGenerator().getRandom() >= survival)
+            {
+                RenderCounters::add(RenderCounters::Counter::roulette_terminations);
+                RenderCounters::addPath(i + 1, false);
+                return Vec3{0,0,0};
+            }
+            attenuation = attenuation/survival;
+        }
     }
+    RenderCounters::addPath(config.max_depth, true);
     return Vec3{0,0,0};
 }
 
 Vec3 Camera::background_colour(const Ray& ray) const
 {
-    Vec3 normalised_direction{ray.getDirection().getNormalised()};
-    const double a {0.5*(normalised_direction[1] + 1.0)};
+    const Real a {(ray.getUnitDirection()[1] + 1)/2};
     return Vec3{(1 - a)*Vec3{1,1,1} + a*Vec3{0.5,0.7,1.0} };
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "Checkpoint.h"
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    constexpr std::array<char, 4> magic{'R', 'T', 'C', 'K'};
+    constexpr std::uint32_t version{2};
+
+    struct Header
+    {
+        std::array<char, 4> magic{};
+        std::uint32_t version{};
+        std::int32_t width{};
+        std::int32_t height{};
+        std::uint64_t seed{};
+        std::uint32_t sampler{};
+        // Names the padding before the fingerprint, so every byte written is initialised.
+        std::uint32_t reserved{};
+        std::uint64_t fingerprint{};
+    };
+    static_assert(sizeof(Header) == 40, "Checkpoint headers are written as they lie in memory, with no padding");
+
+    struct StoredPixel
+    {
+        double sum[3]{};
+        std::int64_t n_samples{};
+    };
+    static_assert(sizeof(StoredPixel) == 32, "Pixels are written as they lie in memory, with no padding");
+}
+
+bool Checkpoint::write(const std::string& filepath, const Identity& identity, const std::vector<Vec3>& sums, const std::vector<int>& sample_counts)
+{
+    std::vector<StoredPixel> pixels(sums.size());
+    for (size_t i{0}; i < sums.size(); ++i)
+    {
+        pixels[i] = StoredPixel{{sums[i][0], sums[i][1], sums[i][2]}, sample_counts[i]};
+    }
+    const std::string temporary_path{filepath + ".tmp"};
+    {
+        std::ofstream file{temporary_path, std::ios::binary};
+        const Header header{magic, version, identity.width, identity.height, identity.seed, static_cast<std::uint32_t>(identity.sampler), 0, identity.fingerprint};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()*sizeof(StoredPixel)));
+        if (!file)
+        {
+            return false;
+        }
+    }
+    std::error_code error{};
+    std::filesystem::rename(temporary_path, filepath, error);
+    return !error;
+}
+
+Checkpoint::Status Checkpoint::read(const std::string& filepath, const Identity& identity, std::vector<Vec3>& sums, std::vector<int>& sample_counts)
+{
+    std::ifstream file{filepath, std::ios::binary};
+    Header header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(Header)) || header.magic != magic || header.version != version)
+    {
+        return Status::missing;
+    }
+    if (header.width != identity.width || header.height != identity.height || header.seed != identity.seed
+        || header.sampler != static_cast<std::uint32_t>(identity.sampler) || header.fingerprint != identity.fingerprint)
+    {
+        return Status::mismatched;
+    }
+    std::vector<StoredPixel> pixels(static_cast<size_t>(identity.width*identity.height));
+    if (!file.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()*sizeof(StoredPixel))))
+    {
+        return Status::missing;
+    }
+    sums.resize(pixels.size());
+    sample_counts.resize(pixels.size());
+    for (size_t i{0}; i < pixels.size(); ++i)
+    {
+        sums[i] = Vec3{pixels[i].sum[0], pixels[i].sum[1], pixels[i].sum[2]};
+        sample_counts[i] = static_cast<int>(pixels[i].n_samples);
+    }
+    return Status::resumed;
+}
@@ -3,11 +3,11 @@
 #include <algorithm>
 #include <cmath>
 
-Vec3 Cuboid::getNormalAtPoint(const Vec3& point) const
+Vec3 Cuboid::getNormalAtPoint(const Vec3& point, const Vec3& position, const Vec3& half_dimensions)
 {
-    const Vec3 offset{(point - position)/dimensions * 2};
+    const Vec3 offset{(point - position)/half_dimensions};
     const Vec3 abs_offset{offset.getAbsolute()};
-    const double maximum_abs_offset{*std::max_element(abs_offset.values.begin(), abs_offset.values.end())};
+    const Real maximum_abs_offset{*std::max_element(abs_offset.values.begin(), abs_offset.values.end())};
     const Vec3 sign{offset/abs_offset};
     const Vec3 normal{
         std::floor(abs_offset[0]/maximum_abs_offset) * sign[0],
@@ -17,26 +17,38 @@ Vec3 Cuboid::getNormalAtPoint(const Vec3& point) const
     return normal;
 }
 
-Interval Cuboid::getRayIntersection(const Ray& ray) const
+Interval Cuboid::getRayIntersection(const Ray& ray, const Vec3& position, const Vec3& half_dimensions)
 {
-    const Vec3 ltb = (lower_bounds - ray.getOrigin())/ray.getDirection();
-    const Vec3 rtb = (upper_bounds - ray.getOrigin())/ray.getDirection();
-    const Interval x_interval{ltb[0] < rtb[0] ? Interval{ltb[0], rtb[0]} : Interval{rtb[0], ltb[0]}};
-    const Interval y_interval{ltb[1] < rtb[1] ? Interval{ltb[1], rtb[1]} : Interval{rtb[1], ltb[1]}};
-    const Interval z_interval{ltb[2] < rtb[2] ? Interval{ltb[2], rtb[2]} : Interval{rtb[2], ltb[2]}};
-    return x_interval.intersect(y_interval).intersect(z_interval);
+    // Each axis's entry and exit are the nearer and further of its two faces, taken with min and max
+    // rather than by comparing and swapping, so the test has no branches to mispredict.
+    const Vec3& inverse_direction{ray.getInverseDirection()};
+    const Vec3 lower{(position - half_dimensions - ray.getOrigin())*inverse_direction};
+    const Vec3 upper{(position + half_dimensions - ray.getOrigin())*inverse_direction};
+    const Real t_near{std::max({std::min(lower[0], upper[0]), std::min(lower[1], upper[1]), std::min(lower[2], upper[2])})};
+    const Real t_far{std::min({std::max(lower[0], upper[0]), std::max(lower[1], upper[1]), std::max(lower[2], upper[2])})};
+    return Interval{t_near, t_far};
 }
 
 Hit Cuboid::getRayHit(const Ray& ray, const Interval& interval) const
 {
-    const Interval ray_interval{getRayIntersection(ray)};
+    return getRayHit(getPosition(ray.getTime()), half_dimensions, getMaterialIndex(), ray, interval);
+}
+
+Hit Cuboid::getRayHit(const Vec3& position, const Vec3& half_dimensions, const Materials::Index material, const Ray& ray, const Interval& interval)
+{
+    const Interval ray_interval{getRayIntersection(ray, position, half_dimensions)};
     const Interval valid_ray_interval{ray_interval.intersect(interval)};
     if (valid_ray_interval.max < valid_ray_interval.min)
     {
         return Hit();
     }
-    const double closest_edge{interval.min == valid_ray_interval.min ? valid_ray_interval.max : valid_ray_interval.min};
+    const Real closest_edge{interval.min == valid_ray_interval.min ? valid_ray_interval.max : valid_ray_interval.min};
     const Vec3 point_on_edge{ray.at(closest_edge)};
-    const Vec3 normal{getNormalAtPoint(point_on_edge)};
-    return Hit{closest_edge, point_on_edge, normal.getNormalised(), getMaterial()};
+    const Vec3 normal{getNormalAtPoint(point_on_edge, position, half_dimensions)};
+    return Hit{closest_edge, point_on_edge, normal.getNormalised(), material};
+}
+
+AABB Cuboid::getBoundingBox(const Interval& time) const
+{
+    return getDynamics().sweep(time).pad(half_dimensions);
 }
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "Denoiser.h"
+#include "TileScheduler.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+    // Edge-stopping strengths: how sharply normals must agree, how many depth gradients apart
+    // neighbours may lie, and how many standard deviations apart their luminance may be.
+    constexpr Real normal_power{4};
+    constexpr Real depth_tolerance{16};
+    constexpr Real luminance_tolerance{4};
+    // Keeps the edge-stopping functions finite where a pixel has no noise or no depth gradient.
+    constexpr Real smallest_scale{static_cast<Real>(1e-4)};
+
+    // The B3 spline, whose outer taps are spread further apart at each iteration.
+    constexpr std::array<Real, 5> spline{Real{1}/16, Real{1}/4, Real{3}/8, Real{1}/4, Real{1}/16};
+
+    Real getLuminance(const Vec3& colour)
+    {
+        return static_cast<Real>(0.2126)*colour[0] + static_cast<Real>(0.7152)*colour[1] + static_cast<Real>(0.0722)*colour[2];
+    }
+
+    Vec3 getDemodulationAlbedo(const Vec3& albedo)
+    {
+        return Vec3{std::max(albedo[0], Denoiser::min_albedo), std::max(albedo[1], Denoiser::min_albedo), std::max(albedo[2], Denoiser::min_albedo)};
+    }
+
+    // The features of every pixel averaged over its samples, and the lighting being filtered.
+    struct Guide
+    {
+        int width{};
+        int height{};
+        std::vector<Vec3> albedo{};
+        std::vector<Vec3> normal{};
+        std::vector<Real> depth{};
+        // How fast depth changes across the screen, in each direction, per pixel.
+        std::vector<Real> depth_dx{};
+        std::vector<Real> depth_dy{};
+
+        size_t getIndex(const int i, const int j) const {return static_cast<size_t>(i + j*width);}
+    };
+
+    Guide makeGuide(const std::vector<PixelFeatures>& features, const int width, const int height)
+    {
+        Guide guide{width, height};
+        guide.albedo.resize(features.size());
+        guide.normal.resize(features.size());
+        guide.depth.resize(features.size());
+        for (size_t i{0}; i < features.size(); ++i)
+        {
+            const Real n{static_cast<Real>(std::max(features[i].n_samples, 1))};
+            guide.albedo[i] = features[i].albedo/n;
+            const Real normal_length{features[i].normal.length()};
+            guide.normal[i] = normal_length > 0 ? features[i].normal/normal_length : Vec3{};
+            guide.depth[i] = features[i].depth/n;
+        }
+        guide.depth_dx.resize(features.size());
+        guide.depth_dy.resize(features.size());
+        for (int j{0}; j < height; ++j)
+        {
+            for (int i{0}; i < width; ++i)
+            {
+                const int left{std::max(i - 1, 0)};
+                const int right{std::min(i + 1, width - 1)};
+                const int up{std::max(j - 1, 0)};
+                const int down{std::min(j + 1, height - 1)};
+                const size_t index{guide.getIndex(i, j)};
+                guide.depth_dx[index] = std::abs(guide.depth[guide.getIndex(right, j)] - guide.depth[guide.getIndex(left, j)])/static_cast<Real>(std::max(right - left, 1));
+                guide.depth_dy[index] = std::abs(guide.depth[guide.getIndex(i, down)] - guide.depth[guide.getIndex(i, up)])/static_cast<Real>(std::max(down - up, 1));
+            }
+        }
+        return guide;
+    }
+
+    // The variance of the pixel's mean luminance, blurred over its 3x3 neighbourhood so a single
+    // unlucky estimate does not decide how hard the pixel is filtered.
+    Real getBlurredVariance(const Guide& guide, const std::vector<Real>& variance, const int i, const int j)
+    {
+        constexpr std::array<Real, 3> weights{Real{1}/4, Real{1}/2, Real{1}/4};
+        Real sum{0};
+        Real weight_sum{0};
+        for (int dy{-1}; dy <= 1; ++dy)
+        {
+            for (int dx{-1}; dx <= 1; ++dx)
+            {
+                const int x{i + dx};
+                const int y{j + dy};
+                if (x >= 0 && x < guide.width && y >= 0 && y < guide.height)
+                {
+                    const Real weight{weights[static_cast<size_t>(dx + 1)]*weights[static_cast<size_t>(dy + 1)]};
+                    sum += weight*variance[guide.getIndex(x, y)];
+                    weight_sum += weight;
+                }
+            }
+        }
+        return sum/weight_sum;
+    }
+
+    void filterPixel(const Guide& guide, const int step, const std::vector<Vec3>& lighting, const std::vector<Real>& variance,
+                     std::vector<Vec3>& filtered_lighting, std::vector<Real>& filtered_variance, const int i, const int j)
+    {
+        const size_t centre{guide.getIndex(i, j)};
+        const Real centre_luminance{getLuminance(lighting[centre])};
+        const Real luminance_scale{luminance_tolerance*std::sqrt(getBlurredVariance(guide, variance, i, j)) + smallest_scale};
+        Vec3 sum{};
+        Real weight_sum{0};
+        Real variance_sum{0};
+        for (int dy{-2}; dy <= 2; ++dy)
+        {
+            for (int dx{-2}; dx <= 2; ++dx)
+            {
+                const int x{i + dx*step};
+                const int y{j + dy*step};
+                if (x < 0 || x >= guide.width || y < 0 || y >= guide.height)
+                {
+                    continue;
+                }
+                const size_t index{guide.getIndex(x, y)};
+                const Real normal_weight{std::pow(std::max<Real>(guide.normal[centre].dot(guide.normal[index]), 0), normal_power)};
+                const Real expected_depth_change{guide.depth_dx[centre]*static_cast<Real>(std::abs(x - i)) + guide.depth_dy[centre]*static_cast<Real>(std::abs(y - j))};
+                const Real depth_weight{std::exp(-std::abs(guide.depth[centre] - guide.depth[index])/(depth_tolerance*expected_depth_change + smallest_scale))};
+                const Real luminance_weight{std::exp(-std::abs(centre_luminance - getLuminance(lighting[index]))/luminance_scale)};
+                const Real weight{spline[static_cast<size_t>(dx + 2)]*spline[static_cast<size_t>(dy + 2)]*normal_weight*depth_weight*luminance_weight};
+                sum += weight*lighting[index];
+                weight_sum += weight;
+                variance_sum += weight*weight*variance[index];
+            }
+        }
+        // A pixel unlike all its neighbours, itself included when it has no normal, is left alone.
+        if (weight_sum <= 0)
+        {
+            filtered_lighting[centre] = lighting[centre];
+            filtered_variance[centre] = variance[centre];
+            return;
+        }
+        filtered_lighting[centre] = sum/weight_sum;
+        filtered_variance[centre] = variance_sum/(weight_sum*weight_sum);
+    }
+}
+
+void PixelFeatures::add(const SampleFeatures& sample, const Vec3& colour)
+{
+    albedo += sample.albedo;
+    normal += sample.normal;
+    depth += sample.depth;
+    const double sample_luminance{getLuminance(colour/getDemodulationAlbedo(sample.albedo))};
+    luminance += sample_luminance;
+    luminance_squared += sample_luminance*sample_luminance;
+    ++n_samples;
+}
+
+void Denoiser::denoise(std::vector<Vec3>& pixel_colours, const std::vector<PixelFeatures>& features, const int width, const int height, const int iterations, const int tile_size, const int n_threads)
+{
+    const Guide guide{makeGuide(features, width, height)};
+    std::vector<Vec3> lighting(pixel_colours.size());
+    std::vector<Real> variance(pixel_colours.size());
+    for (size_t i{0}; i < pixel_colours.size(); ++i)
+    {
+        lighting[i] = pixel_colours[i]/getDemodulationAlbedo(guide.albedo[i]);
+        // The variance of the mean falls with the number of samples; one sample gives no estimate,
+        // so such a pixel is trusted as much as its neighbours allow.
+        const int n{features[i].n_samples};
+        if (n > 1)
+        {
+            const double mean{features[i].luminance/n};
+            const double sample_variance{std::max(features[i].luminance_squared/n - mean*mean, 0.0)*n/(n - 1)};
+            variance[i] = static_cast<Real>(sample_variance/n);
+        }
+        else
+        {
+            variance[i] = static_cast<Real>(getLuminance(lighting[i])*getLuminance(lighting[i]));
+        }
+    }
+
+    std::vector<Vec3> filtered_lighting(lighting.size());
+    std::vector<Real> filtered_variance(variance.size());
+    const TileScheduler scheduler{width, height, tile_size, n_threads, false};
+    // Once the taps are spread further apart than the image is wide, every one but the centre falls
+    // outside it, so further iterations would only overflow the step.
+    const int reach{std::max(width, height)};
+    for (int iteration{0}, step{1}; iteration < iterations && step <= reach; ++iteration, step *= 2)
+    {
+        scheduler.run([&](const Tile& tile)
+        {
+            for (int j{tile.y_min}; j < tile.y_max; ++j)
+            {
+                for (int i{tile.x_min}; i < tile.x_max; ++i)
+                {
+                    filterPixel(guide, step, lighting, variance, filtered_lighting, filtered_variance, i, j);
+                }
+            }
+        });
+        std::swap(lighting, filtered_lighting);
+        std::swap(variance, filtered_variance);
+    }
+
+    for (size_t i{0}; i < pixel_colours.size(); ++i)
+    {
+        pixel_colours[i] = lighting[i]*getDemodulationAlbedo(guide.albedo[i]);
+    }
+}
+
+std::vector<Vec3> Denoiser::getAlbedoImage(const std::vector<PixelFeatures>& features)
+{
+    std::vector<Vec3> image(features.size());
+    for (size_t i{0}; i < features.size(); ++i)
+    {
+        image[i] = features[i].albedo/static_cast<Real>(std::max(features[i].n_samples, 1));
+    }
+    return image;
+}
+
+std::vector<Vec3> Denoiser::getNormalImage(const std::vector<PixelFeatures>& features)
+{
+    std::vector<Vec3> image(features.size());
+    for (size_t i{0}; i < features.size(); ++i)
+    {
+        const Real length{features[i].normal.length()};
+        const Vec3 normal{length > 0 ? features[i].normal/length : Vec3{}};
+        image[i] = (normal + Vec3{1, 1, 1})/2;
+    }
+    return image;
+}
+
+std::vector<double> Denoiser::getDepthImage(const std::vector<PixelFeatures>& features)
+{
+    std::vector<double> image(features.size());
+    double deepest{0.0};
+    for (size_t i{0}; i < features.size(); ++i)
+    {
+        image[i] = static_cast<double>(features[i].depth)/std::max(features[i].n_samples, 1);
+        deepest = std::max(deepest, image[i]);
+    }
+    if (deepest > 0)
+    {
+        for (double& depth : image)
+        {
+            depth /= deepest;
+        }
+    }
+    return image;
+}
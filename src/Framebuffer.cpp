@@ -0,0 +1,31 @@
+#include "Framebuffer.h"
+
+bool FramebufferView::hasSize(const int image_width, const int image_height) const
+{
+    return data != nullptr && width == image_width && height == image_height && stride >= 3*static_cast<std::size_t>(image_width);
+}
+
+void FramebufferView::store(const std::vector<Vec3>& colours, const Tile& tile) const
+{
+    for (int j{tile.y_min}; j < tile.y_max; ++j)
+    {
+        float* pixel{getPixel(tile.x_min, j)};
+        for (int i{tile.x_min}; i < tile.x_max; ++i)
+        {
+            const Vec3& colour{colours[static_cast<std::size_t>(i + j*width)]};
+            *pixel++ = static_cast<float>(colour[0]);
+            *pixel++ = static_cast<float>(colour[1]);
+            *pixel++ = static_cast<float>(colour[2]);
+        }
+    }
+}
+
+void FramebufferView::store(const std::vector<Vec3>& colours) const
+{
+    store(colours, Tile{0, 0, width, height});
+}
+
+Framebuffer::Framebuffer(const int width, const int height)
+    : width{width}, height{height}, pixels(3*static_cast<std::size_t>(width)*static_cast<std::size_t>(height))
+{
+}
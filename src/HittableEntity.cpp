@@ -1,11 +1,6 @@
 #include "HittableEntity.h"
 
-void HittableEntity::at(const double time)
-{
-    position = dynamics->at(time).position;
-}
-
-bool inRange(const double x, const double a, const double b)
+bool inRange(const Real x, const Real a, const Real b)
 {
     return x >= a &&  x < b;
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "ImageReader.h"
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+bool ImageReader::readPFM(const std::string& filepath, std::vector<Vec3>& pixels, int& width, int& height)
+{
+    std::ifstream file{filepath, std::ios::binary};
+    std::string magic{};
+    int file_width{0};
+    int file_height{0};
+    double scale{0.0};
+    if (!(file >> magic >> file_width >> file_height >> scale) || magic != "PF" || file_width <= 0 || file_height <= 0)
+    {
+        return false;
+    }
+    // A single whitespace character separates the header from the data.
+    file.get();
+
+    const size_t row_length{3*static_cast<size_t>(file_width)};
+    std::vector<float> data(row_length*static_cast<size_t>(file_height));
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()*sizeof(float))))
+    {
+        return false;
+    }
+    // The sign of the scale gives the byte order: negative for little-endian.
+    const bool little_endian{scale < 0};
+    if (little_endian != (std::endian::native == std::endian::little))
+    {
+        for (float& value : data)
+        {
+            value = std::bit_cast<float>(std::byteswap(std::bit_cast<std::uint32_t>(value)));
+        }
+    }
+
+    pixels.resize(static_cast<size_t>(file_width*file_height));
+    for (size_t j{0}; j < static_cast<size_t>(file_height); ++j)
+    {
+        const float* row{data.data() + (static_cast<size_t>(file_height) - 1 - j)*row_length};
+        for (size_t i{0}; i < static_cast<size_t>(file_width); ++i)
+        {
+            pixels[j*static_cast<size_t>(file_width) + i] = Vec3{row[3*i], row[3*i + 1], row[3*i + 2]};
+        }
+    }
+    width = file_width;
+    height = file_height;
+    return true;
+}
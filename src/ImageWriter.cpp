@@ -0,0 +1,195 @@
+#include "ImageWriter.h"
+#include "PackedPrimitives.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define IMAGE_WRITER_X86
+#include <immintrin.h>
+#endif
+
+// The quantise pass walks a frame as one flat run of channels.
+static_assert(sizeof(Vec3) == 3*sizeof(Real), "Vec3 must be three tightly packed components");
+
+namespace
+{
+    constexpr int max_colour{255};
+
+    template <typename T>
+    void quantiseScalar(const T* channels, const size_t n_channels, std::uint8_t* output)
+    {
+        for (size_t i{0}; i < n_channels; ++i)
+        {
+            output[i] = ImageWriter::quantise(channels[i]);
+        }
+    }
+
+#if defined(IMAGE_WRITER_X86)
+    // Only the overload matching the renderer's precision is used in a given build.
+    [[maybe_unused]] __attribute__((target("avx2")))
+    void quantiseAVX2(const double* channels, const size_t n_channels, std::uint8_t* output)
+    {
+        const __m256d zero{_mm256_setzero_pd()};
+        const __m256d scale{_mm256_set1_pd(max_colour + 1)};
+        const __m256d ceiling{_mm256_set1_pd(max_colour)};
+        size_t i{0};
+        for (; i + 8 <= n_channels; i += 8)
+        {
+            const __m256d low{_mm256_min_pd(_mm256_mul_pd(_mm256_sqrt_pd(_mm256_max_pd(_mm256_loadu_pd(channels + i), zero)), scale), ceiling)};
+            const __m256d high{_mm256_min_pd(_mm256_mul_pd(_mm256_sqrt_pd(_mm256_max_pd(_mm256_loadu_pd(channels + i + 4), zero)), scale), ceiling)};
+            const __m128i words{_mm_packus_epi32(_mm256_cvttpd_epi32(low), _mm256_cvttpd_epi32(high))};
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(words, words));
+        }
+        quantiseScalar(channels + i, n_channels - i, output + i);
+    }
+
+    [[maybe_unused]] __attribute__((target("avx2")))
+    void quantiseAVX2(const float* channels, const size_t n_channels, std::uint8_t* output)
+    {
+        const __m256 zero{_mm256_setzero_ps()};
+        const __m256 scale{_mm256_set1_ps(max_colour + 1)};
+        const __m256 ceiling{_mm256_set1_ps(max_colour)};
+        size_t i{0};
+        for (; i + 8 <= n_channels; i += 8)
+        {
+            const __m256 scaled{_mm256_min_ps(_mm256_mul_ps(_mm256_sqrt_ps(_mm256_max_ps(_mm256_loadu_ps(channels + i), zero)), scale), ceiling)};
+            const __m256i integers{_mm256_cvttps_epi32(scaled)};
+            const __m128i words{_mm_packus_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1))};
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(words, words));
+        }
+        quantiseScalar(channels + i, n_channels - i, output + i);
+    }
+#endif
+
+    void appendInteger(std::string& buffer, const int value)
+    {
+        char digits[12];
+        const auto result{std::to_chars(std::begin(digits), std::end(digits), value)};
+        buffer.append(digits, result.ptr);
+    }
+}
+
+std::uint8_t ImageWriter::quantise(const double channel)
+{
+    const double gamma_corrected{std::sqrt(std::max(channel, 0.0))};
+    return static_cast<std::uint8_t>(std::min(max_colour, static_cast<int>((max_colour + 1)*gamma_corrected)));
+}
+
+void ImageWriter::quantise(const std::vector<Vec3>& pixels, std::uint8_t* output)
+{
+    if (pixels.empty())
+    {
+        return;
+    }
+    const Real* channels{pixels.front().values.data()};
+    const size_t n_channels{3*pixels.size()};
+#if defined(IMAGE_WRITER_X86)
+    if (PackedKernels::isSupported(PackedKernels::InstructionSet::avx2))
+    {
+        quantiseAVX2(channels, n_channels, output);
+        return;
+    }
+#endif
+    quantiseScalar(channels, n_channels, output);
+}
+
+const char* ImageWriter::getExtension(const ImageFormat format)
+{
+    return format == ImageFormat::pfm ? ".pfm" : ".ppm";
+}
+
+std::string ImageWriter::getPPMHeader(const bool binary, const int width, const int height)
+{
+    return (binary ? "P6\n" : "P3\n") + std::to_string(width) + " " + std::to_string(height) + "\n" + std::to_string(max_colour) + "\n";
+}
+
+std::unique_ptr<ImageEncoder> ImageWriter::makeEncoder(const ImageFormat format)
+{
+    switch (format)
+    {
+    case ImageFormat::ascii_ppm:
+        return std::make_unique<AsciiPPMEncoder>();
+    case ImageFormat::pfm:
+        return std::make_unique<PFMEncoder>();
+    default:
+        return std::make_unique<BinaryPPMEncoder>();
+    }
+}
+
+void ImageWriter::write(const std::string& filepath, const std::vector<Vec3>& pixels, const int width, const int height, const ImageEncoder& encoder)
+{
+    std::string buffer{};
+    encoder.encode(pixels, width, height, buffer);
+    writeBuffer(filepath, buffer);
+}
+
+void ImageWriter::writeBuffer(const std::string& filepath, const std::string& buffer)
+{
+    std::ofstream file{filepath, std::ios::binary};
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void ImageWriter::writeGreyscale(const std::string& filepath, const std::vector<double>& values, const int width, const int height)
+{
+    std::string buffer{"P5\n" + std::to_string(width) + " " + std::to_string(height) + "\n" + std::to_string(max_colour) + "\n"};
+    buffer.reserve(buffer.size() + values.size());
+    for (const double value : values)
+    {
+        buffer += static_cast<char>(std::clamp(static_cast<int>(max_colour*value + 0.5), 0, max_colour));
+    }
+    std::ofstream file{filepath, std::ios::binary};
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void AsciiPPMEncoder::encode(const std::vector<Vec3>& pixels, const int width, const int height, std::string& buffer) const
+{
+    std::vector<std::uint8_t> quantised(3*pixels.size());
+    ImageWriter::quantise(pixels, quantised.data());
+    buffer += ImageWriter::getPPMHeader(false, width, height);
+    // At most "255 255 255\n" per pixel.
+    buffer.reserve(buffer.size() + 12*pixels.size());
+    for (size_t i{0}; i < quantised.size(); i += 3)
+    {
+        appendInteger(buffer, quantised[i]);
+        buffer += ' ';
+        appendInteger(buffer, quantised[i + 1]);
+        buffer += ' ';
+        appendInteger(buffer, quantised[i + 2]);
+        buffer += '\n';
+    }
+}
+
+void BinaryPPMEncoder::encode(const std::vector<Vec3>& pixels, const int width, const int height, std::string& buffer) const
+{
+    buffer += ImageWriter::getPPMHeader(true, width, height);
+    const size_t header_size{buffer.size()};
+    buffer.resize(header_size + 3*pixels.size());
+    ImageWriter::quantise(pixels, reinterpret_cast<std::uint8_t*>(buffer.data() + header_size));
+}
+
+void PFMEncoder::encode(const std::vector<Vec3>& pixels, const int width, const int height, std::string& buffer) const
+{
+    // A negative scale marks little-endian data. Rows run from the bottom of the image up.
+    const char* scale{std::endian::native == std::endian::little ? "-1.0" : "1.0"};
+    buffer += "PF\n" + std::to_string(width) + " " + std::to_string(height) + "\n" + scale + "\n";
+    const size_t row_size{3*sizeof(float)*static_cast<size_t>(width)};
+    const size_t header_size{buffer.size()};
+    buffer.resize(header_size + row_size*static_cast<size_t>(height));
+    std::vector<float> row(3*static_cast<size_t>(width));
+    for (int j{0}; j < height; ++j)
+    {
+        const auto first{static_cast<size_t>((height - 1 - j)*width)};
+        for (size_t i{0}; i < static_cast<size_t>(width); ++i)
+        {
+            const Vec3& pixel{pixels[first + i]};
+            row[3*i] = static_cast<float>(pixel[0]);
+            row[3*i + 1] = static_cast<float>(pixel[1]);
+            row[3*i + 2] = static_cast<float>(pixel[2]);
+        }
+        std::memcpy(buffer.data() + header_size + static_cast<size_t>(j)*row_size, row.data(), row_size);
+    }
+}
@@ -1,70 +1,136 @@
 #include "Material.h"
+#include "RenderCounters.h"
+#include "Sampler.h"
 #include "Utilities.h"
 #include <cmath>
+#include <functional>
 
-Vec3 Lambertian::attenuate(Ray& ray, const Vec3& point, const Vec3& normal) const
+Vec3 Lambertian::attenuate(Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler) const
 {
-    ray.scatter(point, normal);
+    ray.scatter(point, normal, sampler);
     return albedo;
 }
 
-std::unique_ptr<Material> Lambertian::make_unique() const
+Vec3 Reflector::attenuate(Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler) const
 {
-    return std::make_unique<Lambertian>(*this);
-}
-
-Vec3 Reflector::attenuate(Ray& ray, const Vec3& point, const Vec3& normal) const
-{
-    ray.reflect(point, normal, fuzz);
+    ray.reflect(point, normal, fuzz, sampler);
     return albedo;
 }
 
-std::unique_ptr<Material> Reflector::make_unique() const
-{
-    return std::make_unique<Reflector>(*this);
-}
-
-Vec3 Refractor::attenuate(Ray& ray, const Vec3& point, const Vec3& normal) const
+Vec3 Refractor::attenuate(Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler) const
 {
     const bool entering{ray.getDirection().dot(normal) < 0};
     const Vec3 normal_against_ray{entering ? normal : -normal};
-    const double cosine_term{computeCosineTerm(ray.getDirection().getNormalised(), normal_against_ray)};
-    const double refractive_ratio{ray.getRefractiveRatio(entering, refractive_index)};
-    if (canRefract(cosine_term, refractive_ratio) && doesRefract(cosine_term, refractive_ratio))
+    const Real cosine_term{computeCosineTerm(ray.getUnitDirection(), normal_against_ray)};
+    const Real refractive_ratio{ray.getRefractiveRatio(entering, refractive_index)};
+    if (!canRefract(cosine_term, refractive_ratio))
+    {
+        RenderCounters::add(RenderCounters::Counter::total_internal_reflections);
+        ray.reflect(point, normal_against_ray, 0.0, sampler);
+    }
+    else if (doesRefract(cosine_term, refractive_ratio, sampler))
     {
+        RenderCounters::add(RenderCounters::Counter::refractions);
         ray.refract(point, normal_against_ray, refractive_index, cosine_term, entering);
     }
     else
     {
-        ray.reflect(point, normal_against_ray, 0.0);
+        RenderCounters::add(RenderCounters::Counter::reflections);
+        ray.reflect(point, normal_against_ray, 0.0, sampler);
     }
     return Vec3{1.0, 1.0, 1.0};
 }
 
-std::unique_ptr<Material> Refractor::make_unique() const
+Real Refractor::computeCosineTerm(const Vec3& normalised_direction, const Vec3& normal)
+{
+    return std::min<Real>((-normalised_direction).dot(normal), 1);
+}
+
+bool Refractor::canRefract(Real cosine_term, const Real refractive_ratio)
 {
-    return std::make_unique<Refractor>(*this);
+    const Real sin_term{std::sqrt(1 - cosine_term*cosine_term)};
+    return refractive_ratio * sin_term <= 1.0;
 }
 
-double Refractor::computeCosineTerm(const Vec3& normalised_direction, const Vec3& normal)
+bool Refractor::doesRefract(const Real cosine_term, const Real refractive_ratio, Sampler& sampler)
 {
-    return std::min((-normalised_direction).dot(normal), 1.0);
+    return computeSchickApproximation(cosine_term, refractive_ratio) < sampler.get1D();
 }
 
-bool Refractor::canRefract(double cosine_term, const double refractive_ratio)
+Real Refractor::computeSchickApproximation(const Real cosine_term, const Real refractive_ratio)
 {
-    const double sin_term{std::sqrt(1.0 - cosine_term*cosine_term)};
-    return refractive_ratio * sin_term <= 1.0;
+    Real r0 {(1 - refractive_ratio)/(1 + refractive_ratio)};
+    r0 = r0*r0;
+    return r0 + (1 - r0)*static_cast<Real>(std::pow((1 - cosine_term), 5));
 }
 
-bool Refractor::doesRefract(const double cosine_term, const double refractive_ratio)
+Vec3 Materials::attenuate(const Material& material, Ray& ray, const Vec3& point, const Vec3& normal, Sampler& sampler)
 {
-    return computeSchickApproximation(cosine_term, refractive_ratio) < Random::getRandom();
+    // Cases follow the order of the alternatives in Material.
+    switch (material.index())
+    {
+        case 0:
+            return std::get_if<Lambertian>(&material)->attenuate(ray, point, normal, sampler);
+        case 1:
+            return std::get_if<Reflector>(&material)->attenuate(ray, point, normal, sampler);
+        default:
+            return std::get_if<Refractor>(&material)->attenuate(ray, point, normal, sampler);
+    }
 }
 
-double Refractor::computeSchickApproximation(const double cosine_term, const double refractive_ratio)
+namespace
 {
-    double r0 {(1 - refractive_ratio)/(1 + refractive_ratio)};
-    r0 = r0*r0;
-    return r0 + (1 - r0)*std::pow((1 - cosine_term), 5);
-}
\ No newline at end of file
+    size_t combine(const size_t seed, const Real value)
+    {
+        // Boost's hash_combine.
+        return seed ^ (std::hash<Real>{}(value) + 0x9e3779b9 + (seed << 6u) + (seed >> 2u));
+    }
+
+    size_t combine(size_t seed, const Vec3& vec)
+    {
+        for (int i{0}; i < 3; ++i)
+        {
+            seed = combine(seed, vec[i]);
+        }
+        return seed;
+    }
+}
+
+Materials::Index MaterialLibrary::add(const Material& material)
+{
+    const auto [position, inserted]{indices.try_emplace(material, static_cast<Materials::Index>(materials.size()))};
+    if (inserted)
+    {
+        materials.push_back(material);
+    }
+    return position->second;
+}
+
+size_t MaterialLibrary::getMemoryUsage() const
+{
+    // Each hash table node holds a key, its value, the cached hash and a link to the next node.
+    const size_t node_bytes{sizeof(std::pair<const Material, Materials::Index>) + 2*sizeof(void*)};
+    return materials.capacity()*sizeof(Material) + indices.bucket_count()*sizeof(void*) + indices.size()*node_bytes;
+}
+
+size_t Materials::Hash::operator()(const Material& material) const
+{
+    const size_t seed{material.index()};
+    return std::visit([seed](const auto& parameters)
+    {
+        using Parameters = std::decay_t<decltype(parameters)>;
+        const size_t albedo_hash{combine(seed, parameters.albedo)};
+        if constexpr (std::is_same_v<Parameters, Reflector>)
+        {
+            return combine(albedo_hash, parameters.fuzz);
+        }
+        else if constexpr (std::is_same_v<Parameters, Refractor>)
+        {
+            return combine(albedo_hash, parameters.refractive_index);
+        }
+        else
+        {
+            return albedo_hash;
+        }
+    }, material);
+}
@@ -0,0 +1,438 @@
+#include "PackedPrimitives.h"
+#include "Constants.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PACKED_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+void SpherePack::clear()
+{
+    centre_x.clear();
+    centre_y.clear();
+    centre_z.clear();
+    radius.clear();
+    primitive.clear();
+}
+
+void SpherePack::add(const Vec3& centre, const double sphere_radius, const std::uint32_t primitive_index)
+{
+    centre_x.push_back(centre[0]);
+    centre_y.push_back(centre[1]);
+    centre_z.push_back(centre[2]);
+    radius.push_back(sphere_radius);
+    primitive.push_back(primitive_index);
+}
+
+void SpherePack::pad()
+{
+    const size_t padded_size{size() + PackedKernels::padding};
+    centre_x.resize(padded_size);
+    centre_y.resize(padded_size);
+    centre_z.resize(padded_size);
+    radius.resize(padded_size);
+}
+
+void CuboidPack::clear()
+{
+    lower_x.clear();
+    lower_y.clear();
+    lower_z.clear();
+    upper_x.clear();
+    upper_y.clear();
+    upper_z.clear();
+    primitive.clear();
+}
+
+void CuboidPack::add(const Vec3& lower_bounds, const Vec3& upper_bounds, const std::uint32_t primitive_index)
+{
+    lower_x.push_back(lower_bounds[0]);
+    lower_y.push_back(lower_bounds[1]);
+    lower_z.push_back(lower_bounds[2]);
+    upper_x.push_back(upper_bounds[0]);
+    upper_y.push_back(upper_bounds[1]);
+    upper_z.push_back(upper_bounds[2]);
+    primitive.push_back(primitive_index);
+}
+
+void CuboidPack::pad()
+{
+    const size_t padded_size{size() + PackedKernels::padding};
+    lower_x.resize(padded_size);
+    lower_y.resize(padded_size);
+    lower_z.resize(padded_size);
+    upper_x.resize(padded_size);
+    upper_y.resize(padded_size);
+    upper_z.resize(padded_size);
+}
+
+PackedRay::PackedRay(const Ray& ray)
+    : origin{ray.getOrigin()},
+      direction{ray.getDirection()},
+      inverse_direction{ray.getInverseDirection()},
+      length_squared{ray.getLengthSquared()}
+{
+}
+
+namespace
+{
+    PackedHit intersectSpheresScalar(const SpherePack& pack, const size_t first, const size_t count, const PackedRay& ray, const PackedInterval& interval)
+    {
+        PackedHit closest{-1, Constants::infinity};
+        for (size_t i{first}; i < first + count; ++i)
+        {
+            const PackedVec3 origin_to_origin{pack.centre_x[i] - ray.origin[0], pack.centre_y[i] - ray.origin[1], pack.centre_z[i] - ray.origin[2]};
+            const double h{ray.direction.dot(origin_to_origin)};
+            const double c{origin_to_origin.lengthSquared() - pack.radius[i]*pack.radius[i]};
+            const double discriminant{h*h - ray.length_squared*c};
+            if (discriminant < 0)
+            {
+                continue;
+            }
+            const double first_part{h/ray.length_squared};
+            const double second_part{std::sqrt(discriminant)/ray.length_squared};
+            double root{first_part - second_part};
+            if (!interval.contains(root))
+            {
+                root = first_part + second_part;
+                if (!interval.contains(root))
+                {
+                    continue;
+                }
+            }
+            if (root < closest.t)
+            {
+                closest = PackedHit{static_cast<std::int64_t>(i), root};
+            }
+        }
+        return closest;
+    }
+
+    PackedHit intersectCuboidsScalar(const CuboidPack& pack, const size_t first, const size_t count, const PackedRay& ray, const PackedInterval& interval)
+    {
+        PackedHit closest{-1, Constants::infinity};
+        const std::array<const AlignedVector<double>*, 3> lower{&pack.lower_x, &pack.lower_y, &pack.lower_z};
+        const std::array<const AlignedVector<double>*, 3> upper{&pack.upper_x, &pack.upper_y, &pack.upper_z};
+        for (size_t i{first}; i < first + count; ++i)
+        {
+            double t_near{-Constants::infinity};
+            double t_far{Constants::infinity};
+            for (size_t axis{0}; axis < 3; ++axis)
+            {
+                const int component{static_cast<int>(axis)};
+                const double t0{((*lower[axis])[i] - ray.origin[component])*ray.inverse_direction[component]};
+                const double t1{((*upper[axis])[i] - ray.origin[component])*ray.inverse_direction[component]};
+                t_near = std::max(t_near, std::min(t0, t1));
+                t_far = std::min(t_far, std::max(t0, t1));
+            }
+            const double valid_min{std::max(t_near, interval.min)};
+            const double valid_max{std::min(t_far, interval.max)};
+            if (valid_max < valid_min)
+            {
+                continue;
+            }
+            const double closest_edge{t_near <= interval.min ? valid_max : valid_min};
+            if (closest_edge < closest.t)
+            {
+                closest = PackedHit{static_cast<std::int64_t>(i), closest_edge};
+            }
+        }
+        return closest;
+    }
+
+#if defined(PACKED_KERNELS_X86)
+    template <size_t Width>
+    PackedHit reduceLanes(const std::array<double, Width>& t, const std::array<double, Width>& index)
+    {
+        PackedHit closest{-1, Constants::infinity};
+        for (size_t lane{0}; lane < Width; ++lane)
+        {
+            if (index[lane] >= 0 && t[lane] < closest.t)
+            {
+                closest = PackedHit{static_cast<std::int64_t>(index[lane]), t[lane]};
+            }
+        }
+        return closest;
+    }
+
+    __attribute__((target("avx2,fma")))
+    PackedHit intersectSpheresAVX2(const SpherePack& pack, const size_t first, const size_t count, const PackedRay& ray, const PackedInterval& interval)
+    {
+        const __m256d origin_x{_mm256_set1_pd(ray.origin[0])};
+        const __m256d origin_y{_mm256_set1_pd(ray.origin[1])};
+        const __m256d origin_z{_mm256_set1_pd(ray.origin[2])};
+        const __m256d direction_x{_mm256_set1_pd(ray.direction[0])};
+        const __m256d direction_y{_mm256_set1_pd(ray.direction[1])};
+        const __m256d direction_z{_mm256_set1_pd(ray.direction[2])};
+        const __m256d a{_mm256_set1_pd(ray.length_squared)};
+        const __m256d t_min{_mm256_set1_pd(interval.min)};
+        const __m256d t_max{_mm256_set1_pd(interval.max)};
+        const __m256d zero{_mm256_setzero_pd()};
+        const __m256d infinity{_mm256_set1_pd(Constants::infinity)};
+        const __m256d lanes{_mm256_set_pd(3.0, 2.0, 1.0, 0.0)};
+        const __m256d end{_mm256_set1_pd(static_cast<double>(first + count))};
+        __m256d best_t{infinity};
+        __m256d best_index{_mm256_set1_pd(-1.0)};
+        for (size_t i{first}; i < first + count; i += 4)
+        {
+            const __m256d index{_mm256_add_pd(lanes, _mm256_set1_pd(static_cast<double>(i)))};
+            const __m256d to_centre_x{_mm256_sub_pd(_mm256_loadu_pd(pack.centre_x.data() + i), origin_x)};
+            const __m256d to_centre_y{_mm256_sub_pd(_mm256_loadu_pd(pack.centre_y.data() + i), origin_y)};
+            const __m256d to_centre_z{_mm256_sub_pd(_mm256_loadu_pd(pack.centre_z.data() + i), origin_z)};
+            const __m256d radius{_mm256_loadu_pd(pack.radius.data() + i)};
+            const __m256d h{_mm256_fmadd_pd(direction_x, to_centre_x, _mm256_fmadd_pd(direction_y, to_centre_y, _mm256_mul_pd(direction_z, to_centre_z)))};
+            const __m256d distance_squared{_mm256_fmadd_pd(to_centre_x, to_centre_x, _mm256_fmadd_pd(to_centre_y, to_centre_y, _mm256_mul_pd(to_centre_z, to_centre_z)))};
+            const __m256d c{_mm256_fnmadd_pd(radius, radius, distance_squared)};
+            const __m256d discriminant{_mm256_fnmadd_pd(a, c, _mm256_mul_pd(h, h))};
+            const __m256d first_part{_mm256_div_pd(h, a)};
+            const __m256d second_part{_mm256_div_pd(_mm256_sqrt_pd(_mm256_max_pd(discriminant, zero)), a)};
+            const __m256d near_root{_mm256_sub_pd(first_part, second_part)};
+            const __m256d far_root{_mm256_add_pd(first_part, second_part)};
+            const __m256d near_valid{_mm256_and_pd(_mm256_cmp_pd(near_root, t_min, _CMP_GE_OQ), _mm256_cmp_pd(near_root, t_max, _CMP_LE_OQ))};
+            const __m256d far_valid{_mm256_and_pd(_mm256_cmp_pd(far_root, t_min, _CMP_GE_OQ), _mm256_cmp_pd(far_root, t_max, _CMP_LE_OQ))};
+            const __m256d hit{_mm256_and_pd(
+                _mm256_and_pd(_mm256_cmp_pd(discriminant, zero, _CMP_GE_OQ), _mm256_cmp_pd(index, end, _CMP_LT_OQ)),
+                _mm256_or_pd(near_valid, far_valid))};
+            const __m256d root{_mm256_blendv_pd(far_root, near_root, near_valid)};
+            const __m256d t{_mm256_blendv_pd(infinity, root, hit)};
+            const __m256d closer{_mm256_cmp_pd(t, best_t, _CMP_LT_OQ)};
+            best_t = _mm256_blendv_pd(best_t, t, closer);
+            best_index = _mm256_blendv_pd(best_index, index, closer);
+        }
+        std::array<double, 4> t{};
+        std::array<double, 4> index{};
+        _mm256_storeu_pd(t.data(), best_t);
+        _mm256_storeu_pd(index.data(), best_index);
+        return reduceLanes(t, index);
+    }
+
+    __attribute__((target("avx2,fma")))
+    inline void clipToSlabAVX2(const double* lower, const double* upper, const double origin, const double inverse_direction, __m256d& t_near, __m256d& t_far)
+    {
+        const __m256d t0{_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(lower), _mm256_set1_pd(origin)), _mm256_set1_pd(inverse_direction))};
+        const __m256d t1{_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(upper), _mm256_set1_pd(origin)), _mm256_set1_pd(inverse_direction))};
+        t_near = _mm256_max_pd(t_near, _mm256_min_pd(t0, t1));
+        t_far = _mm256_min_pd(t_far, _mm256_max_pd(t0, t1));
+    }
+
+    __attribute__((target("avx2,fma")))
+    PackedHit intersectCuboidsAVX2(const CuboidPack& pack, const size_t first, const size_t count, const PackedRay& ray, const PackedInterval& interval)
+    {
+        const __m256d t_min{_mm256_set1_pd(interval.min)};
+        const __m256d t_max{_mm256_set1_pd(interval.max)};
+        const __m256d infinity{_mm256_set1_pd(Constants::infinity)};
+        const __m256d lanes{_mm256_set_pd(3.0, 2.0, 1.0, 0.0)};
+        const __m256d end{_mm256_set1_pd(static_cast<double>(first + count))};
+        __m256d best_t{infinity};
+        __m256d best_index{_mm256_set1_pd(-1.0)};
+        for (size_t i{first}; i < first + count; i += 4)
+        {
+            const __m256d index{_mm256_add_pd(lanes, _mm256_set1_pd(static_cast<double>(i)))};
+            __m256d t_near{_mm256_set1_pd(-Constants::infinity)};
+            __m256d t_far{infinity};
+            clipToSlabAVX2(pack.lower_x.data() + i, pack.upper_x.data() + i, ray.origin[0], ray.inverse_direction[0], t_near, t_far);
+            clipToSlabAVX2(pack.lower_y.data() + i, pack.upper_y.data() + i, ray.origin[1], ray.inverse_direction[1], t_near, t_far);
+            clipToSlabAVX2(pack.lower_z.data() + i, pack.upper_z.data() + i, ray.origin[2], ray.inverse_direction[2], t_near, t_far);
+            const __m256d valid_min{_mm256_max_pd(t_near, t_min)};
+            const __m256d valid_max{_mm256_min_pd(t_far, t_max)};
+            const __m256d hit{_mm256_and_pd(_mm256_cmp_pd(valid_min, valid_max, _CMP_LE_OQ), _mm256_cmp_pd(index, end, _CMP_LT_OQ))};
+            const __m256d closest_edge{_mm256_blendv_pd(valid_min, valid_max, _mm256_cmp_pd(t_near, t_min, _CMP_LE_OQ))};
+            const __m256d t{_mm256_blendv_pd(infinity, closest_edge, hit)};
+            const __m256d closer{_mm256_cmp_pd(t, best_t, _CMP_LT_OQ)};
+            best_t = _mm256_blendv_pd(best_t, t, closer);
+            best_index = _mm256_blendv_pd(best_index, index, closer);
+        }
+        std::array<double, 4> t{};
+        std::array<double, 4> index{};
+        _mm256_storeu_pd(t.data(), best_t);
+        _mm256_storeu_pd(index.data(), best_index);
+        return reduceLanes(t, index);
+    }
+
+// GCC 12 flags the deliberately undefined pass-through operands inside the AVX-512 intrinsics.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+    __attribute__((target("avx512f")))
+    PackedHit intersectSpheresAVX512(const SpherePack& pack, const size_t first, const size_t count, const PackedRay& ray, const PackedInterval& interval)
+    {
+        const __m512d origin_x{_mm512_set1_pd(ray.origin[0])};
+        const __m512d origin_y{_mm512_set1_pd(ray.origin[1])};
+        const __m512d origin_z{_mm512_set1_pd(ray.origin[2])};
+        const __m512d direction_x{_mm512_set1_pd(ray.direction[0])};
+        const __m512d direction_y{_mm512_set1_pd(ray.direction[1])};
+        const __m512d direction_z{_mm512_set1_pd(ray.direction[2])};
+        const __m512d a{_mm512_set1_pd(ray.length_squared)};
+        const __m512d t_min{_mm512_set1_pd(interval.min)};
+        const __m512d t_max{_mm512_set1_pd(interval.max)};
+        const __m512d zero{_mm512_setzero_pd()};
+        const __m512d infinity{_mm512_set1_pd(Constants::infinity)};
+        const __m512d lanes{_mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0)};
+        __m512d best_t{infinity};
+        __m512d best_index{_mm512_set1_pd(-1.0)};
+        for (size_t i{first}; i < first + count; i += 8)
+        {
+            const size_t remaining{first + count - i};
+            const auto in_range{static_cast<__mmask8>(remaining >= 8 ? 0xffu : (1u << remaining) - 1u)};
+            const __m512d index{_mm512_add_pd(lanes, _mm512_set1_pd(static_cast<double>(i)))};
+            const __m512d to_centre_x{_mm512_sub_pd(_mm512_loadu_pd(pack.centre_x.data() + i), origin_x)};
+            const __m512d to_centre_y{_mm512_sub_pd(_mm512_loadu_pd(pack.centre_y.data() + i), origin_y)};
+            const __m512d to_centre_z{_mm512_sub_pd(_mm512_loadu_pd(pack.centre_z.data() + i), origin_z)};
+            const __m512d radius{_mm512_loadu_pd(pack.radius.data() + i)};
+            const __m512d h{_mm512_fmadd_pd(direction_x, to_centre_x, _mm512_fmadd_pd(direction_y, to_centre_y, _mm512_mul_pd(direction_z, to_centre_z)))};
+            const __m512d distance_squared{_mm512_fmadd_pd(to_centre_x, to_centre_x, _mm512_fmadd_pd(to_centre_y, to_centre_y, _mm512_mul_pd(to_centre_z, to_centre_z)))};
+            const __m512d c{_mm512_fnmadd_pd(radius, radius, distance_squared)};
+            const __m512d discriminant{_mm512_fnmadd_pd(a, c, _mm512_mul_pd(h, h))};
+            const __m512d first_part{_mm512_div_pd(h, a)};
+            const __m512d second_part{_mm512_div_pd(_mm512_sqrt_pd(_mm512_max_pd(discriminant, zero)), a)};
+            const __m512d near_root{_mm512_sub_pd(first_part, second_part)};
+            const __m512d far_root{_mm512_add_pd(first_part, second_part)};
+            const __mmask8 near_valid{static_cast<__mmask8>(
+                _mm512_cmp_pd_mask(near_root, t_min, _CMP_GE_OQ) & _mm512_cmp_pd_mask(near_root, t_max, _CMP_LE_OQ))};
+            const __mmask8 far_valid{static_cast<__mmask8>(
+                _mm512_cmp_pd_mask(far_root, t_min, _CMP_GE_OQ) & _mm512_cmp_pd_mask(far_root, t_max, _CMP_LE_OQ))};
+            const __mmask8 hit{static_cast<__mmask8>(
+                _mm512_cmp_pd_mask(discriminant, zero, _CMP_GE_OQ) & in_range & (near_valid | far_valid))};
+            const __m512d root{_mm512_mask_blend_pd(near_valid, far_root, near_root)};
+            const __m512d t{_mm512_mask_blend_pd(hit, infinity, root)};
+            const __mmask8 closer{_mm512_cmp_pd_mask(t, best_t, _CMP_LT_OQ)};
+            best_t = _mm512_mask_blend_pd(closer, best_t, t);
+            best_index = _mm512_mask_blend_pd(closer, best_index, index);
+        }
+        std::array<double, 8> t{};
+        std::array<double, 8> index{};
+        _mm512_storeu_pd(t.data(), best_t);
+        _mm512_storeu_pd(index.data(), best_index);
+        return reduceLanes(t, index);
+    }
+
+    __attribute__((target("avx512f")))
+    inline void clipToSlabAVX512(const double* lower, const double* upper, const double origin, const double inverse_direction, __m512d& t_near, __m512d& t_far)
+    {
+        const __m512d t0{_mm512_mul_pd(_mm512_sub_pd(_mm512_loadu_pd(lower), _mm512_set1_pd(origin)), _mm512_set1_pd(inverse_direction))};
+        const __m512d t1{_mm512_mul_pd(_mm512_sub_pd(_mm512_loadu_pd(upper), _mm512_set1_pd(origin)), _mm512_set1_pd(inverse_direction))};
+        t_near = _mm512_max_pd(t_near, _mm512_min_pd(t0, t1));
+        t_far = _mm512_min_pd(t_far, _mm512_max_pd(t0, t1));
+    }
+
+    __attribute__((target("avx512f")))
+    PackedHit intersectCuboidsAVX512(const CuboidPack& pack, const size_t first, const size_t count, const PackedRay& ray, const PackedInterval& interval)
+    {
+        const __m512d t_min{_mm512_set1_pd(interval.min)};
+        const __m512d t_max{_mm512_set1_pd(interval.max)};
+        const __m512d infinity{_mm512_set1_pd(Constants::infinity)};
+        const __m512d lanes{_mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0)};
+        __m512d best_t{infinity};
+        __m512d best_index{_mm512_set1_pd(-1.0)};
+        for (size_t i{first}; i < first + count; i += 8)
+        {
+            const size_t remaining{first + count - i};
+            const auto in_range{static_cast<__mmask8>(remaining >= 8 ? 0xffu : (1u << remaining) - 1u)};
+            const __m512d index{_mm512_add_pd(lanes, _mm512_set1_pd(static_cast<double>(i)))};
+            __m512d t_near{_mm512_set1_pd(-Constants::infinity)};
+            __m512d t_far{infinity};
+            clipToSlabAVX512(pack.lower_x.data() + i, pack.upper_x.data() + i, ray.origin[0], ray.inverse_direction[0], t_near, t_far);
+            clipToSlabAVX512(pack.lower_y.data() + i, pack.upper_y.data() + i, ray.origin[1], ray.inverse_direction[1], t_near, t_far);
+            clipToSlabAVX512(pack.lower_z.data() + i, pack.upper_z.data() + i, ray.origin[2], ray.inverse_direction[2], t_near, t_far);
+            const __m512d valid_min{_mm512_max_pd(t_near, t_min)};
+            const __m512d valid_max{_mm512_min_pd(t_far, t_max)};
+            const __mmask8 hit{static_cast<__mmask8>(_mm512_cmp_pd_mask(valid_min, valid_max, _CMP_LE_OQ) & in_range)};
+            const __m512d closest_edge{_mm512_mask_blend_pd(_mm512_cmp_pd_mask(t_near, t_min, _CMP_LE_OQ), valid_min, valid_max)};
+            const __m512d t{_mm512_mask_blend_pd(hit, infinity, closest_edge)};
+            const __mmask8 closer{_mm512_cmp_pd_mask(t, best_t, _CMP_LT_OQ)};
+            best_t = _mm512_mask_blend_pd(closer, best_t, t);
+            best_index = _mm512_mask_blend_pd(closer, best_index, index);
+        }
+        std::array<double, 8> t{};
+        std::array<double, 8> index{};
+        _mm512_storeu_pd(t.data(), best_t);
+        _mm512_storeu_pd(index.data(), best_index);
+        return reduceLanes(t, index);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+}
+
+bool PackedKernels::isSupported(const InstructionSet instruction_set)
+{
+    switch (instruction_set)
+    {
+    case InstructionSet::scalar:
+        return true;
+#if defined(PACKED_KERNELS_X86)
+    case InstructionSet::avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case InstructionSet::avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+PackedKernels::InstructionSet PackedKernels::getBestInstructionSet()
+{
+    static const InstructionSet best{[]
+    {
+        for (const InstructionSet instruction_set : {InstructionSet::avx512, InstructionSet::avx2})
+        {
+            if (isSupported(instruction_set))
+            {
+                return instruction_set;
+            }
+        }
+        return InstructionSet::scalar;
+    }()};
+    return best;
+}
+
+const char* PackedKernels::getName(const InstructionSet instruction_set)
+{
+    switch (instruction_set)
+    {
+    case InstructionSet::avx2:
+        return "avx2";
+    case InstructionSet::avx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+PackedKernels::SphereKernel PackedKernels::getSphereKernel(const InstructionSet instruction_set)
+{
+#if defined(PACKED_KERNELS_X86)
+    if (instruction_set == InstructionSet::avx512 && isSupported(instruction_set))
+    {
+        return intersectSpheresAVX512;
+    }
+    if (instruction_set == InstructionSet::avx2 && isSupported(instruction_set))
+    {
+        return intersectSpheresAVX2;
+    }
+#endif
+    static_cast<void>(instruction_set);
+    return intersectSpheresScalar;
+}
+
+PackedKernels::CuboidKernel PackedKernels::getCuboidKernel(const InstructionSet instruction_set)
+{
+#if defined(PACKED_KERNELS_X86)
+    if (instruction_set == InstructionSet::avx512 && isSupported(instruction_set))
+    {
+        return intersectCuboidsAVX512;
+    }
+    if (instruction_set == InstructionSet::avx2 && isSupported(instruction_set))
+    {
+        return intersectCuboidsAVX2;
+    }
+#endif
+    static_cast<void>(instruction_set);
+    return intersectCuboidsScalar;
+}
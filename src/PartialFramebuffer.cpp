@@ -0,0 +1,149 @@
+#include "PartialFramebuffer.h"
+#include <array>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    constexpr std::array<char, 4> magic{'R', 'T', 'P', 'F'};
+    constexpr std::uint32_t version{1};
+
+    struct Header
+    {
+        std::array<char, 4> magic{};
+        std::uint32_t version{};
+        std::int32_t width{};
+        std::int32_t height{};
+        std::uint32_t n_runs{};
+    };
+
+    // A stretch of consecutive sampled pixels, followed in the file by its pixels.
+    struct Run
+    {
+        std::uint32_t first{};
+        std::uint32_t length{};
+    };
+
+    struct StoredPixel
+    {
+        float colour[3]{};
+        std::uint32_t n_samples{};
+    };
+
+    template <typename T>
+    void writeValue(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool readValue(std::ifstream& file, T& value)
+    {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+}
+
+PartialFramebuffer::PartialFramebuffer(const int width, const int height)
+    : width{width},
+      height{height},
+      colours(static_cast<size_t>(width*height)),
+      sample_counts(static_cast<size_t>(width*height))
+{
+}
+
+PartialFramebuffer::PartialFramebuffer(const int width, const int height, const std::vector<Vec3>& colours, const std::vector<int>& sample_counts)
+    : width{width},
+      height{height},
+      colours{colours},
+      sample_counts(sample_counts.begin(), sample_counts.end())
+{
+}
+
+bool PartialFramebuffer::merge(const PartialFramebuffer& partial)
+{
+    if (partial.width != width || partial.height != height)
+    {
+        return false;
+    }
+    for (size_t i{0}; i < colours.size(); ++i)
+    {
+        const std::uint32_t n_other{partial.sample_counts[i]};
+        if (n_other == 0)
+        {
+            continue;
+        }
+        const std::uint32_t n_total{sample_counts[i] + n_other};
+        colours[i] = (colours[i]*static_cast<Real>(sample_counts[i]) + partial.colours[i]*static_cast<Real>(n_other))/static_cast<Real>(n_total);
+        sample_counts[i] = n_total;
+    }
+    return true;
+}
+
+bool PartialFramebuffer::write(const std::string& filepath) const
+{
+    std::vector<Run> runs{};
+    for (size_t i{0}; i < sample_counts.size(); ++i)
+    {
+        if (sample_counts[i] == 0)
+        {
+            continue;
+        }
+        if (!runs.empty() && runs.back().first + runs.back().length == i)
+        {
+            ++runs.back().length;
+        }
+        else
+        {
+            runs.push_back(Run{static_cast<std::uint32_t>(i), 1});
+        }
+    }
+
+    std::ofstream file{filepath, std::ios::binary};
+    writeValue(file, Header{magic, version, width, height, static_cast<std::uint32_t>(runs.size())});
+    std::vector<StoredPixel> pixels{};
+    for (const Run& run : runs)
+    {
+        writeValue(file, run);
+        pixels.resize(run.length);
+        for (std::uint32_t i{0}; i < run.length; ++i)
+        {
+            const Vec3& colour{colours[run.first + i]};
+            pixels[i] = StoredPixel{{static_cast<float>(colour[0]), static_cast<float>(colour[1]), static_cast<float>(colour[2])}, sample_counts[run.first + i]};
+        }
+        file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()*sizeof(StoredPixel)));
+    }
+    return static_cast<bool>(file);
+}
+
+bool PartialFramebuffer::read(const std::string& filepath)
+{
+    std::ifstream file{filepath, std::ios::binary};
+    Header header{};
+    if (!readValue(file, header) || header.magic != magic || header.version != version || header.width <= 0 || header.height <= 0)
+    {
+        return false;
+    }
+    PartialFramebuffer partial{header.width, header.height};
+    std::vector<StoredPixel> pixels{};
+    for (std::uint32_t r{0}; r < header.n_runs; ++r)
+    {
+        Run run{};
+        if (!readValue(file, run) || static_cast<size_t>(run.first) + run.length > partial.colours.size())
+        {
+            return false;
+        }
+        pixels.resize(run.length);
+        if (!file.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()*sizeof(StoredPixel))))
+        {
+            return false;
+        }
+        for (std::uint32_t i{0}; i < run.length; ++i)
+        {
+            const StoredPixel& pixel{pixels[i]};
+            partial.colours[run.first + i] = Vec3{pixel.colour[0], pixel.colour[1], pixel.colour[2]};
+            partial.sample_counts[run.first + i] = pixel.n_samples;
+        }
+    }
+    *this = std::move(partial);
+    return true;
+}
@@ -1,19 +1,20 @@
 #include "Ray.h"
+#include "Sampler.h"
 #include <cassert>
 #include "Utilities.h"
 #include <cmath>
 
-Vec3 Ray::at(const double t) const
+Vec3 Ray::at(const Real t) const
 {
     return getOrigin() + direction * t;
 }
 
-double Ray::at(const Vec3& point_on_ray) const
+Real Ray::at(const Vec3& point_on_ray) const
 {
     return (point_on_ray[0] - getOrigin()[0])/direction[0];
 }
 
-void Ray::reflect(const Vec3& at_point, const Vec3& at_normal, const double fuzz)
+void Ray::reflect(const Vec3& at_point, const Vec3& at_normal, const Real fuzz, Sampler& sampler)
 {
     Vec3 in_direction{Vec3::getReflected(direction, at_normal)};
     if (fuzz == 0)
@@ -23,7 +24,7 @@ void Ray::reflect(const Vec3& at_point, const Vec3& at_normal, const double fuzz
     }
     while (true)
     {
-        in_direction = in_direction.getNormalised() + fuzz * Vec3::getRandomUnit();
+        in_direction = in_direction.getNormalised() + fuzz * sampler.getUnitVector();
         if (in_direction.dot(at_normal) > 0)
         {
             update(at_point, in_direction);
@@ -32,9 +33,9 @@ void Ray::reflect(const Vec3& at_point, const Vec3& at_normal, const double fuzz
     }
 }
 
-void Ray::scatter(const Vec3& at_point, const Vec3& at_normal)
+void Ray::scatter(const Vec3& at_point, const Vec3& at_normal, Sampler& sampler)
 {
-    Vec3 in_direction{at_normal + Vec3::getRandomUnit()};
+    Vec3 in_direction{at_normal + sampler.getUnitVector()};
     if (direction.isNearZero())
     {
         assert("Tried to scatter but direction was near zero");
@@ -42,21 +43,21 @@ void Ray::scatter(const Vec3& at_point, const Vec3& at_normal)
     update(at_point, in_direction);
 }
 
-void Ray::refract(const Vec3& at_point, const Vec3& at_normal, const double refractive_index, const double cosine_term, const bool entering)
+void Ray::refract(const Vec3& at_point, const Vec3& at_normal, const Real refractive_index, const Real cosine_term, const bool entering)
 {
-    double refractive_ratio{};
+    Real refractive_ratio{};
     if (entering)
     {
         refractive_ratio = getRefractiveRatio(true, refractive_index);
-        refraction_log.push_back(refractive_index);
+        enterMedium(refractive_index);
     }
     else
     {
         refractive_ratio = getRefractiveRatio(false);
-        refraction_log.pop_back();
+        exitMedium();
     }
-    const Vec3 perpendicular {refractive_ratio * (direction.getNormalised() + cosine_term * at_normal)};
-    const Vec3 parallel {-std::sqrt(std::abs(1.0 - perpendicular.lengthSquared())) * at_normal};
+    const Vec3 perpendicular {refractive_ratio * (unit_direction + cosine_term * at_normal)};
+    const Vec3 parallel {-std::sqrt(std::abs(1 - perpendicular.lengthSquared())) * at_normal};
     const Vec3 refracted_direction{perpendicular + parallel};
     update(at_point, refracted_direction);
 }
@@ -64,16 +65,53 @@ void Ray::refract(const Vec3& at_point, const Vec3& at_normal, const double refr
 void Ray::update(const Vec3& at_position, const Vec3& in_direction)
 {
     direction = in_direction;
-    points.push_back(at_position);
+    origin = at_position;
+    cacheDirectionTerms();
 }
 
-double Ray::getRefractiveRatio(const bool entering, const double refractive_index)
+void Ray::cacheDirectionTerms()
 {
-    if (entering)
+    inverse_direction = Vec3{1/direction[0], 1/direction[1], 1/direction[2]};
+    length_squared = direction.lengthSquared();
+    unit_direction = direction/std::sqrt(length_squared);
+    // Taken from the inverse so that a negative zero component, whose inverse is -inf, counts as negative.
+    direction_signs = static_cast<std::uint8_t>(static_cast<unsigned>(inverse_direction[0] < 0)
+                                                | static_cast<unsigned>(inverse_direction[1] < 0) << 1u
+                                                | static_cast<unsigned>(inverse_direction[2] < 0) << 2u);
+}
+
+void Ray::enterMedium(const Real refractive_index)
+{
+    if (n_recorded_media < max_nested_media)
     {
-        return refraction_log.back()/refractive_index;
+        refraction_log[n_recorded_media++] = refractive_index;
+        return;
     }
-    const size_t size {refraction_log.size()};
-    return refraction_log[size - 1]/refraction_log[size - 2];
+    ++n_unrecorded_media;
+}
 
+void Ray::exitMedium()
+{
+    if (n_unrecorded_media > 0)
+    {
+        --n_unrecorded_media;
+    }
+    else if (n_recorded_media > 1)
+    {
+        --n_recorded_media;
+    }
+}
+
+Real Ray::getRefractiveRatio(const bool entering, const Real refractive_index)
+{
+    if (entering)
+    {
+        return refraction_log[n_recorded_media - 1]/refractive_index;
+    }
+    // Leaving a medium the ray was never seen to enter, e.g. after grazing an edge.
+    if (n_recorded_media < 2)
+    {
+        return 1.0;
+    }
+    return refraction_log[n_recorded_media - 1]/refraction_log[n_recorded_media - 2];
 }
\ No newline at end of file
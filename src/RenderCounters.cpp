@@ -0,0 +1,121 @@
+#include "RenderCounters.h"
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+namespace
+{
+    const char* getName(const RenderCounters::Counter counter)
+    {
+        using enum RenderCounters::Counter;
+        switch (counter)
+        {
+            case primary_rays: return "primary_rays";
+            case secondary_rays: return "secondary_rays";
+            case sphere_tests: return "sphere_tests";
+            case cuboid_tests: return "cuboid_tests";
+            case entity_tests: return "entity_tests";
+            case packed_sphere_tests: return "packed_sphere_tests";
+            case packed_cuboid_tests: return "packed_cuboid_tests";
+            case hits: return "hits";
+            case misses: return "misses";
+            case refractions: return "refractions";
+            case reflections: return "reflections";
+            case total_internal_reflections: return "total_internal_reflections";
+            case random_units: return "random_units";
+            case random_unit_rejections: return "random_unit_rejections";
+            case roulette_terminations: return "roulette_terminations";
+            default: return "unknown";
+        }
+    }
+
+#ifdef RAYTRACER_STATISTICS
+    std::mutex& getMutex()
+    {
+        static std::mutex mutex{};
+        return mutex;
+    }
+
+    // Tallies of the threads that have exited since the last reset.
+    RenderCounters::Tally& getRetiredTally()
+    {
+        static RenderCounters::Tally tally{};
+        return tally;
+    }
+#endif
+}
+
+RenderCounters::Tally& RenderCounters::Tally::operator+=(const Tally& other)
+{
+    for (size_t i{0}; i < counts.size(); ++i)
+    {
+        counts[i] += other.counts[i];
+    }
+    for (size_t i{0}; i < path_depths.size(); ++i)
+    {
+        path_depths[i] += other.path_depths[i];
+    }
+    truncated_paths += other.truncated_paths;
+    return *this;
+}
+
+RenderCounters::PhaseTimes& RenderCounters::PhaseTimes::operator+=(const PhaseTimes& other)
+{
+    render += other.render;
+    denoise += other.denoise;
+    encode += other.encode;
+    write += other.write;
+    return *this;
+}
+
+#ifdef RAYTRACER_STATISTICS
+RenderCounters::ThreadTally::~ThreadTally()
+{
+    const std::lock_guard lock{getMutex()};
+    getRetiredTally() += tally;
+}
+
+RenderCounters::Tally RenderCounters::collect()
+{
+    const std::lock_guard lock{getMutex()};
+    Tally total{getRetiredTally()};
+    total += thread_tally.tally;
+    return total;
+}
+
+void RenderCounters::reset()
+{
+    const std::lock_guard lock{getMutex()};
+    getRetiredTally() = Tally{};
+    thread_tally.tally = Tally{};
+}
+#endif
+
+bool RenderCounters::writeJSON(const std::string& filepath, const Tally& tally, const PhaseTimes& times)
+{
+    std::ofstream file{filepath};
+    if (!file)
+    {
+        return false;
+    }
+    file << "{\n  \"counters\": {\n";
+    for (size_t i{0}; i < tally.counts.size(); ++i)
+    {
+        file << "    \"" << getName(static_cast<Counter>(i)) << "\": " << tally.counts[i] << (i + 1 < tally.counts.size() ? "," : "") << "\n";
+    }
+    // The histogram stops at the deepest path seen rather than running out to max_histogram_depth.
+    size_t n_depths{tally.path_depths.size()};
+    while (n_depths > 0 && tally.path_depths[n_depths - 1] == 0)
+    {
+        --n_depths;
+    }
+    file << "  },\n  \"path_depths\": [";
+    for (size_t i{0}; i < n_depths; ++i)
+    {
+        file << (i > 0 ? ", " : "") << tally.path_depths[i];
+    }
+    file << "],\n  \"truncated_paths\": " << tally.truncated_paths << ",\n";
+    file << std::setprecision(9);
+    file << "  \"seconds\": {\"render\": " << times.render << ", \"denoise\": " << times.denoise << ", \"encode\": " << times.encode << ", \"write\": " << times.write << "}\n}\n";
+    return static_cast<bool>(file);
+}
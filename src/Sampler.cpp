@@ -0,0 +1,386 @@
+#include "Sampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace
+{
+    constexpr size_t mask_size{64};
+
+    std::uint32_t hash(const std::uint64_t a, const std::uint64_t b, const std::uint64_t c = 0)
+    {
+        return static_cast<std::uint32_t>(Random::mix(a ^ Random::mix(b ^ Random::mix(c))));
+    }
+
+    // Maps 32 bits to [0, 1), rounding down where single precision would otherwise reach 1.
+    Real toCanonical(const std::uint32_t bits)
+    {
+        static const Real largest{std::nextafter(Real{1}, Real{0})};
+        return std::min(static_cast<Real>(std::ldexp(static_cast<double>(bits), -32)), largest);
+    }
+
+    std::uint32_t reverseBits(std::uint32_t x)
+    {
+        x = ((x >> 1u) & 0x55555555u) | ((x & 0x55555555u) << 1u);
+        x = ((x >> 2u) & 0x33333333u) | ((x & 0x33333333u) << 2u);
+        x = ((x >> 4u) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4u);
+        x = ((x >> 8u) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8u);
+        return (x >> 16u) | (x << 16u);
+    }
+
+    // A hash that only lets each bit depend on the bits below it, which with the bits reversed is
+    // an Owen scramble: a random permutation of every binary subinterval within its parent.
+    std::uint32_t scramble(std::uint32_t x, const std::uint32_t seed)
+    {
+        x = reverseBits(x);
+        x += seed;
+        x ^= x*0x6c50b47cu;
+        x ^= x*0xb82f1e52u;
+        x ^= x*0xc7afe638u;
+        x ^= x*0x8d22f6e6u;
+        return reverseBits(x);
+    }
+
+    // The first two dimensions of the Sobol sequence: the van der Corput sequence and its partner.
+    std::array<std::uint32_t, 2> getSobol(const std::uint32_t index)
+    {
+        std::uint32_t y{0};
+        for (std::uint32_t bits{index}, v{1u << 31u}; bits != 0; bits >>= 1u, v ^= v >> 1u)
+        {
+            if (bits & 1u)
+            {
+                y ^= v;
+            }
+        }
+        return {reverseBits(index), y};
+    }
+
+    std::array<Real, 2> getScrambledSobol(const std::uint32_t index, const std::uint32_t seed)
+    {
+        // Scrambling the index shuffles the order of the points without breaking up the
+        // power-of-two prefixes that are well stratified, so any budget gets a good set.
+        const auto [x, y]{getSobol(scramble(index, seed))};
+        return {toCanonical(scramble(x, hash(seed, 1))), toCanonical(scramble(y, hash(seed, 2)))};
+    }
+
+    // Kensler's hashed permutation of [0, length), for shuffling strata.
+    std::uint32_t permute(std::uint32_t index, const std::uint32_t length, const std::uint32_t seed)
+    {
+        std::uint32_t mask{length - 1};
+        mask |= mask >> 1u;
+        mask |= mask >> 2u;
+        mask |= mask >> 4u;
+        mask |= mask >> 8u;
+        mask |= mask >> 16u;
+        do
+        {
+            index ^= seed;
+            index *= 0xe170893du;
+            index ^= seed >> 16u;
+            index ^= (index & mask) >> 4u;
+            index ^= seed >> 8u;
+            index *= 0x0929eb3fu;
+            index ^= seed >> 23u;
+            index ^= (index & mask) >> 1u;
+            index *= 1u | seed >> 27u;
+            index *= 0x6935fa69u;
+            index ^= (index & mask) >> 11u;
+            index *= 0x74dcb303u;
+            index ^= (index & mask) >> 2u;
+            index *= 0x9e501cc3u;
+            index ^= (index & mask) >> 2u;
+            index *= 0xc860a3dfu;
+            index &= mask;
+            index ^= index >> 5u;
+        } while (index >= length);
+        return (index + seed) % length;
+    }
+
+    // A tileable blue-noise mask made by void and cluster (Ulichney, 1993): each texel holds its
+    // rank in an order where every prefix of texels is as evenly spread as possible, as a value in
+    // [0, 1). Built once, on first use, from a fixed seed.
+    std::vector<Real> makeBlueNoiseMask()
+    {
+        constexpr size_t n_texels{mask_size*mask_size};
+        constexpr double sigma{1.5};
+        std::vector<double> kernel(n_texels);
+        for (size_t y{0}; y < mask_size; ++y)
+        {
+            for (size_t x{0}; x < mask_size; ++x)
+            {
+                const auto dx{static_cast<double>(std::min(x, mask_size - x))};
+                const auto dy{static_cast<double>(std::min(y, mask_size - y))};
+                kernel[x + y*mask_size] = std::exp(-(dx*dx + dy*dy)/(2*sigma*sigma));
+            }
+        }
+        std::vector<bool> pattern(n_texels, false);
+        std::vector<double> energy(n_texels, 0.0);
+        const auto toggle{[&](const size_t texel, const bool set)
+        {
+            pattern[texel] = set;
+            const double sign{set ? 1.0 : -1.0};
+            const size_t tx{texel % mask_size};
+            const size_t ty{texel / mask_size};
+            for (size_t y{0}; y < mask_size; ++y)
+            {
+                for (size_t x{0}; x < mask_size; ++x)
+                {
+                    const size_t dx{(x + mask_size - tx) % mask_size};
+                    const size_t dy{(y + mask_size - ty) % mask_size};
+                    energy[x + y*mask_size] += sign*kernel[dx + dy*mask_size];
+                }
+            }
+        }};
+        // The tightest cluster is the set texel with the most energy, the largest void the unset
+        // texel with the least.
+        const auto find{[&](const bool set, const bool highest)
+        {
+            size_t best{n_texels};
+            for (size_t texel{0}; texel < n_texels; ++texel)
+            {
+                if (pattern[texel] == set && (best == n_texels || (highest ? energy[texel] > energy[best] : energy[texel] < energy[best])))
+                {
+                    best = texel;
+                }
+            }
+            return best;
+        }};
+
+        // Start from a tenth of the texels, set at random, and move clusters into voids until the
+        // pattern settles, which it does well within one move per texel.
+        Random::Generator generator{0x5eed};
+        constexpr size_t n_initial{n_texels/10};
+        for (size_t n_set{0}; n_set < n_initial;)
+        {
+            const size_t texel{generator.next() % n_texels};
+            if (!pattern[texel])
+            {
+                toggle(texel, true);
+                ++n_set;
+            }
+        }
+        for (size_t move{0}; move < n_texels; ++move)
+        {
+            const size_t cluster{find(true, true)};
+            toggle(cluster, false);
+            const size_t gap{find(false, false)};
+            toggle(gap, true);
+            if (gap == cluster)
+            {
+                break;
+            }
+        }
+
+        std::vector<size_t> ranks(n_texels);
+        const std::vector<bool> initial_pattern{pattern};
+        const std::vector<double> initial_energy{energy};
+        for (size_t rank{n_initial}; rank-- > 0;)
+        {
+            const size_t cluster{find(true, true)};
+            toggle(cluster, false);
+            ranks[cluster] = rank;
+        }
+        pattern = initial_pattern;
+        energy = initial_energy;
+        for (size_t rank{n_initial}; rank < n_texels; ++rank)
+        {
+            const size_t gap{find(false, false)};
+            toggle(gap, true);
+            ranks[gap] = rank;
+        }
+
+        std::vector<Real> mask(n_texels);
+        for (size_t texel{0}; texel < n_texels; ++texel)
+        {
+            mask[texel] = static_cast<Real>((static_cast<double>(ranks[texel]) + 0.5)/n_texels);
+        }
+        return mask;
+    }
+
+    Real getBlueNoise(const std::uint32_t x, const std::uint32_t y)
+    {
+        static const std::vector<Real> mask{makeBlueNoiseMask()};
+        return mask[(x % mask_size) + (y % mask_size)*mask_size];
+    }
+}
+
+Sampler::Sampler(const SamplerType type, const std::uint64_t seed, const std::uint64_t pixel_index, const int pixel_x, const int pixel_y, const int sample, const int n_samples)
+    : type{type}, generator{Random::getSampleGenerator(seed, pixel_index, static_cast<std::uint64_t>(sample) + 1)}, seed{seed},
+      pixel_index{pixel_index}, pixel_x{pixel_x}, pixel_y{pixel_y}, sample{static_cast<std::uint32_t>(sample)},
+      n_samples{static_cast<std::uint32_t>(std::max(n_samples, 1))}
+{
+}
+
+std::array<Real, 2> Sampler::getPixelSample()
+{
+    if (type == SamplerType::independent)
+    {
+        return {generator.getRandom(), generator.getRandom()};
+    }
+    return getPoint(pixel_dimension);
+}
+
+std::array<Real, 2> Sampler::getLensSample()
+{
+    if (type == SamplerType::independent)
+    {
+        while (true)
+        {
+            const Real x{generator.getRandom(DefinedIntervals::unit)};
+            const Real y{generator.getRandom(DefinedIntervals::unit)};
+            if (x*x + y*y < 1)
+            {
+                return {x, y};
+            }
+        }
+    }
+    // Shirley and Chiu's concentric mapping, which keeps the strata of the square intact.
+    const auto [u, v]{getPoint(lens_dimension)};
+    const Real a{2*u - 1};
+    const Real b{2*v - 1};
+    if (a == 0 && b == 0)
+    {
+        return {0, 0};
+    }
+    constexpr Real quarter_pi{std::numbers::pi_v<Real>/4};
+    const bool horizontal{std::abs(a) > std::abs(b)};
+    const Real radius{horizontal ? a : b};
+    const Real angle{horizontal ? quarter_pi*(b/a) : 2*quarter_pi - quarter_pi*(a/b)};
+    return {radius*std::cos(angle), radius*std::sin(angle)};
+}
+
+Real Sampler::getTimeSample()
+{
+    if (type == SamplerType::independent)
+    {
+        return generator.getRandom();
+    }
+    return getPoint(time_dimension)[0];
+}
+
+void Sampler::startBounce(const int bounce)
+{
+    if (bounce >= max_bounces)
+    {
+        dimension = dimension_end = 0;
+        return;
+    }
+    dimension = first_bounce_dimension + bounce*dimensions_per_bounce;
+    dimension_end = dimension + dimensions_per_bounce;
+}
+
+Real Sampler::get1D()
+{
+    if (!hasDimensions(1))
+    {
+        return generator.getRandom();
+    }
+    const Real value{getPoint(dimension)[0]};
+    dimension += 1;
+    return value;
+}
+
+std::array<Real, 2> Sampler::get2D()
+{
+    if (!hasDimensions(2))
+    {
+        return {generator.getRandom(), generator.getRandom()};
+    }
+    const std::array<Real, 2> point{getPoint(dimension)};
+    dimension += 2;
+    return point;
+}
+
+Vec3 Sampler::getUnitVector()
+{
+    // Rejection sampling wastes nothing when the numbers are independent, but would scatter the
+    // strata of a low-discrepancy pair, so those are mapped onto the sphere directly.
+    if (!hasDimensions(2))
+    {
+        return Vec3::getRandomUnit(generator);
+    }
+    const auto [u, v]{get2D()};
+    const Real z{1 - 2*u};
+    const Real radius{std::sqrt(std::max<Real>(0, 1 - z*z))};
+    const Real angle{2*std::numbers::pi_v<Real>*v};
+    return Vec3{radius*std::cos(angle), radius*std::sin(angle), z};
+}
+
+bool Sampler::hasDimensions(const int n) const
+{
+    return type != SamplerType::independent && dimension + n <= dimension_end;
+}
+
+std::array<Real, 2> Sampler::getPoint(const int dimension) const
+{
+    switch (type)
+    {
+        case SamplerType::stratified:
+        {
+            // As square a grid of strata as the budget allows, visited in a shuffled order, with
+            // any strata beyond the budget left empty at random.
+            const auto n_columns{static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<double>(n_samples))))};
+            const std::uint32_t n_rows{(n_samples + n_columns - 1)/n_columns};
+            const std::uint32_t n_strata{n_columns*n_rows};
+            const std::uint32_t stratum{permute(sample % n_strata, n_strata, hash(seed, pixel_index, static_cast<std::uint64_t>(dimension)))};
+            const std::uint32_t jitter{hash(seed ^ sample, pixel_index, static_cast<std::uint64_t>(dimension))};
+            const std::uint32_t jitter_y{hash(jitter, sample)};
+            return
+            {
+                (static_cast<Real>(stratum % n_columns) + toCanonical(jitter))/static_cast<Real>(n_columns),
+                (static_cast<Real>(stratum / n_columns) + toCanonical(jitter_y))/static_cast<Real>(n_rows)
+            };
+        }
+        case SamplerType::sobol:
+            return getScrambledSobol(sample, hash(seed, pixel_index, static_cast<std::uint64_t>(dimension)));
+        case SamplerType::blue_noise:
+        {
+            // Every pixel shares the sequence; each dimension reads the mask at offsets of its own.
+            const std::array<Real, 2> point{getScrambledSobol(sample, hash(seed, ~std::uint64_t{0}, static_cast<std::uint64_t>(dimension)))};
+            const std::uint32_t offsets{hash(seed, static_cast<std::uint64_t>(dimension))};
+            const auto shifted{[](const Real value, const Real shift)
+            {
+                const Real sum{value + shift};
+                return std::min(sum >= 1 ? sum - 1 : sum, std::nextafter(Real{1}, Real{0}));
+            }};
+            const auto x{static_cast<std::uint32_t>(pixel_x)};
+            const auto y{static_cast<std::uint32_t>(pixel_y)};
+            return
+            {
+                shifted(point[0], getBlueNoise(x + (offsets & 0xffu), y + ((offsets >> 8u) & 0xffu))),
+                shifted(point[1], getBlueNoise(x + ((offsets >> 16u) & 0xffu), y + (offsets >> 24u)))
+            };
+        }
+        default:
+            return {0, 0};
+    }
+}
+
+const char* Sampler::getName(const SamplerType type)
+{
+    switch (type)
+    {
+        case SamplerType::independent:
+            return "independent";
+        case SamplerType::stratified:
+            return "stratified";
+        case SamplerType::sobol:
+            return "sobol";
+        default:
+            return "blue_noise";
+    }
+}
+
+bool Sampler::parse(const std::string& name, SamplerType& type)
+{
+    for (const SamplerType candidate : {SamplerType::independent, SamplerType::stratified, SamplerType::sobol, SamplerType::blue_noise})
+    {
+        if (name == getName(candidate))
+        {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,32 +1,382 @@
 #include "Scene.h"
+#include "RenderCounters.h"
+#include "Sampler.h"
 #include "Utilities.h"
+#include <algorithm>
+
+namespace
+{
+    // Where a packed primitive is, given the positions of moving primitives at its time slice.
+    template <typename Record>
+    Vec3 getPackedPosition(const Record& record, const Vec3* positions)
+    {
+        return record.dynamics == no_dynamics ? record.centre : positions[record.dynamics];
+    }
+}
 
 Hit Scene::getClosestHit(const Ray& ray, const Interval& space_interval) const
 {
-    double closest_so_far{space_interval.max};
+    // Primitives added since the last build are not in the hierarchies yet.
+    if (n_built_primitives != size())
+    {
+        return getClosestHitLinear(ray, space_interval);
+    }
+    Hit closest_hit{bvh.getClosestHit(ray, space_interval, [this, &ray](const std::uint32_t index, const Interval& interval)
+    {
+        return getRayHit(bvh_primitives[index], ray, interval);
+    })};
+    Real closest_so_far{closest_hit ? closest_hit.t : space_interval.max};
+
+    const PackedRay packed_ray{ray};
+    const Hit static_hit{getClosestPackedHit(static_geometry, nullptr, ray, packed_ray, Interval{space_interval.min, closest_so_far})};
+    if (static_hit)
+    {
+        closest_so_far = static_hit.t;
+        closest_hit = static_hit;
+    }
+    if (!time_slices.empty())
+    {
+        const size_t slice{getTimeSlice(ray.getTime())};
+        const Hit moving_hit{getClosestPackedHit(time_slices[slice], &slice_positions[slice*dynamics.size()], ray, packed_ray, Interval{space_interval.min, closest_so_far})};
+        if (moving_hit)
+        {
+            closest_hit = moving_hit;
+        }
+    }
+    return closest_hit;
+}
+
+Hit Scene::getClosestPackedHit(const PackedGeometry& geometry, const Vec3* positions, const Ray& ray, const PackedRay& packed_ray, const Interval& space_interval) const
+{
+    // The kernels only pick the nearest packed primitive in a leaf; its record then builds the Hit.
+    Hit closest_hit{geometry.sphere_bvh.getClosestLeafHit(ray, space_interval,
+        [this, &geometry, positions, &ray, &packed_ray](const std::uint32_t first, const std::uint32_t count, const Interval& interval)
+    {
+        RenderCounters::add(RenderCounters::Counter::packed_sphere_tests, count);
+        const PackedHit packed_hit{sphere_kernel(geometry.sphere_pack, first, count, packed_ray, PackedInterval{interval.min, interval.max})};
+        if (!packed_hit)
+        {
+            return Hit{};
+        }
+        const SphereRecord& sphere{spheres[geometry.sphere_pack.primitive[static_cast<size_t>(packed_hit.index)]]};
+        return Sphere::getRayHit(getPackedPosition(sphere, positions), sphere.radius, sphere.material, ray, interval);
+    })};
+    const Real closest_so_far{closest_hit ? closest_hit.t : space_interval.max};
+
+    const Hit cuboid_hit{geometry.cuboid_bvh.getClosestLeafHit(ray, Interval{space_interval.min, closest_so_far},
+        [this, &geometry, positions, &ray, &packed_ray](const std::uint32_t first, const std::uint32_t count, const Interval& interval)
+    {
+        RenderCounters::add(RenderCounters::Counter::packed_cuboid_tests, count);
+        const PackedHit packed_hit{cuboid_kernel(geometry.cuboid_pack, first, count, packed_ray, PackedInterval{interval.min, interval.max})};
+        if (!packed_hit)
+        {
+            return Hit{};
+        }
+        const CuboidRecord& cuboid{cuboids[geometry.cuboid_pack.primitive[static_cast<size_t>(packed_hit.index)]]};
+        return Cuboid::getRayHit(getPackedPosition(cuboid, positions), cuboid.half_dimensions, cuboid.material, ray, interval);
+    })};
+    if (cuboid_hit)
+    {
+        closest_hit = cuboid_hit;
+    }
+    return closest_hit;
+}
+
+Hit Scene::getRayHit(const SphereRecord& sphere, const Ray& ray, const Interval& interval) const
+{
+    RenderCounters::add(RenderCounters::Counter::sphere_tests);
+    return Sphere::getRayHit(getPosition(sphere.centre, sphere.dynamics, ray.getTime()), sphere.radius, sphere.material, ray, interval);
+}
+
+Hit Scene::getRayHit(const CuboidRecord& cuboid, const Ray& ray, const Interval& interval) const
+{
+    RenderCounters::add(RenderCounters::Counter::cuboid_tests);
+    return Cuboid::getRayHit(getPosition(cuboid.centre, cuboid.dynamics, ray.getTime()), cuboid.half_dimensions, cuboid.material, ray, interval);
+}
+
+Hit Scene::getRayHit(const PrimitiveReference& primitive, const Ray& ray, const Interval& interval) const
+{
+    switch (primitive.type)
+    {
+        case PrimitiveType::sphere:
+            return getRayHit(spheres[primitive.index], ray, interval);
+        case PrimitiveType::cuboid:
+            return getRayHit(cuboids[primitive.index], ray, interval);
+        default:
+            RenderCounters::add(RenderCounters::Counter::entity_tests);
+            return entities[primitive.index]->getRayHit(ray, interval);
+    }
+}
+
+AABB Scene::getBoundingBox(const Vec3& centre, const DynamicsIndex index, const Interval& time) const
+{
+    return index == no_dynamics ? AABB::fromPoints(centre, centre) : dynamics[index]->sweep(time);
+}
+
+Vec3 Scene::getPosition(const Vec3& centre, const DynamicsIndex index, const Real time) const
+{
+    if (index == no_dynamics)
+    {
+        return centre;
+    }
+    if (const std::optional<Newtonian>& newtonian{newtonian_dynamics[index]})
+    {
+        return newtonian->positionAt(time);
+    }
+    return dynamics[index]->at(time).position;
+}
+
+void Scene::addSphere(const Sphere& sphere)
+{
+    spheres.push_back({sphere.getPosition(0), sphere.getRadius(), addMaterial(sphere.getMaterial()), addDynamics(sphere.getDynamics())});
+}
+
+void Scene::addCuboid(const Cuboid& cuboid)
+{
+    cuboids.push_back({cuboid.getPosition(0), cuboid.getHalfDimensions(), addMaterial(cuboid.getMaterial()), addDynamics(cuboid.getDynamics())});
+}
+
+void Scene::addRecord(const SphereRecord& sphere)
+{
+    spheres.push_back(sphere);
+}
+
+void Scene::addRecord(const CuboidRecord& cuboid)
+{
+    cuboids.push_back(cuboid);
+}
+
+void Scene::borrowRecords(const std::span<const SphereRecord> sphere_records, const std::span<const CuboidRecord> cuboid_records, const std::shared_ptr<const void>& owner)
+{
+    spheres.borrow(sphere_records, owner);
+    cuboids.borrow(cuboid_records, owner);
+}
+
+void Scene::addEntity(std::unique_ptr<HittableEntity> entity)
+{
+    has_motion = has_motion || !entity->getDynamics().isStatic();
+    entity->setMaterialIndex(addMaterial(entity->getMaterial()));
+    entities.push_back(std::move(entity));
+}
+
+MaterialReport Scene::getMaterialReport() const
+{
+    const size_t n_references{spheres.size() + cuboids.size() + entities.size()};
+    return MaterialReport{materials.size(), n_references, materials.getMemoryUsage(), n_references*sizeof(Material)};
+}
+
+Materials::Index Scene::addMaterial(const Material& material)
+{
+    return materials.add(material);
+}
+
+DynamicsIndex Scene::addDynamics(const Dynamics& primitive_dynamics)
+{
+    if (primitive_dynamics.isStatic())
+    {
+        return no_dynamics;
+    }
+    has_motion = true;
+    dynamics.push_back(primitive_dynamics.make_unique());
+    const auto* newtonian{dynamic_cast<const Newtonian*>(&primitive_dynamics)};
+    newtonian_dynamics.push_back(newtonian ? std::optional<Newtonian>{*newtonian} : std::nullopt);
+    return static_cast<DynamicsIndex>(dynamics.size() - 1);
+}
+
+Hit Scene::getClosestHitLinear(const Ray& ray, const Interval& space_interval) const
+{
+    Real closest_so_far{space_interval.max};
     Hit closest_hit {};
-    for (const std::unique_ptr<HittableEntity>& entity : entities)
+    const auto test{[&closest_so_far, &closest_hit](const Hit& hit)
     {
-        Hit hit{entity->getRayHit(ray, Interval{space_interval.min, closest_so_far})};
         if (hit)
         {
             closest_so_far = hit.t;
             closest_hit = hit;
         }
+    }};
+    for (const SphereRecord& sphere : spheres)
+    {
+        test(getRayHit(sphere, ray, Interval{space_interval.min, closest_so_far}));
+    }
+    for (const CuboidRecord& cuboid : cuboids)
+    {
+        test(getRayHit(cuboid, ray, Interval{space_interval.min, closest_so_far}));
+    }
+    for (const std::unique_ptr<HittableEntity>& entity : entities)
+    {
+        RenderCounters::add(RenderCounters::Counter::entity_tests);
+        test(entity->getRayHit(ray, Interval{space_interval.min, closest_so_far}));
     }
     return closest_hit;
 }
 
+void Scene::build()
+{
+    // Moving spheres and cuboids are only sliced when there is an interval to slice.
+    const bool sliced{n_time_slices > 0 && interval.size() > 0 && !dynamics.empty()};
+    std::vector<AABB> bounds{};
+    std::vector<std::uint32_t> static_spheres{};
+    std::vector<std::uint32_t> moving_spheres{};
+    std::vector<std::uint32_t> static_cuboids{};
+    std::vector<std::uint32_t> moving_cuboids{};
+    bvh_primitives.clear();
+    for (size_t i{0}; i < spheres.size(); ++i)
+    {
+        const SphereRecord& sphere{spheres[i]};
+        const auto index{static_cast<std::uint32_t>(i)};
+        if (sphere.dynamics == no_dynamics)
+        {
+            static_spheres.push_back(index);
+        }
+        else if (sliced)
+        {
+            moving_spheres.push_back(index);
+        }
+        else
+        {
+            bounds.push_back(getBoundingBox(sphere.centre, sphere.dynamics, interval).pad(Vec3{sphere.radius, sphere.radius, sphere.radius}));
+            bvh_primitives.push_back({PrimitiveType::sphere, index});
+        }
+    }
+    for (size_t i{0}; i < cuboids.size(); ++i)
+    {
+        const CuboidRecord& cuboid{cuboids[i]};
+        const auto index{static_cast<std::uint32_t>(i)};
+        if (cuboid.dynamics == no_dynamics)
+        {
+            static_cuboids.push_back(index);
+        }
+        else if (sliced)
+        {
+            moving_cuboids.push_back(index);
+        }
+        else
+        {
+            bounds.push_back(getBoundingBox(cuboid.centre, cuboid.dynamics, interval).pad(cuboid.half_dimensions));
+            bvh_primitives.push_back({PrimitiveType::cuboid, index});
+        }
+    }
+    for (size_t i{0}; i < entities.size(); ++i)
+    {
+        bounds.push_back(entities[i]->getBoundingBox(interval));
+        bvh_primitives.push_back({PrimitiveType::entity, static_cast<std::uint32_t>(i)});
+    }
+    bvh.build(bounds);
+    buildPacked(static_geometry, static_spheres, static_cuboids, nullptr);
+
+    time_slices.clear();
+    slice_positions.clear();
+    if (sliced)
+    {
+        buildTimeSlices(moving_spheres, moving_cuboids);
+    }
+    n_built_primitives = size();
+}
+
+void Scene::buildPacked(PackedGeometry& geometry, const std::vector<std::uint32_t>& sphere_indices, const std::vector<std::uint32_t>& cuboid_indices, const Vec3* positions) const
+{
+    std::vector<AABB> sphere_bounds{};
+    for (const std::uint32_t index : sphere_indices)
+    {
+        const SphereRecord& sphere{spheres[index]};
+        const Vec3 position{getPackedPosition(sphere, positions)};
+        sphere_bounds.push_back(AABB::fromPoints(position, position).pad(Vec3{sphere.radius, sphere.radius, sphere.radius}));
+    }
+    std::vector<AABB> cuboid_bounds{};
+    for (const std::uint32_t index : cuboid_indices)
+    {
+        const CuboidRecord& cuboid{cuboids[index]};
+        const Vec3 position{getPackedPosition(cuboid, positions)};
+        cuboid_bounds.push_back(AABB::fromPoints(position, position).pad(cuboid.half_dimensions));
+    }
+
+    // Copy packed primitives in leaf order, so that every leaf is a contiguous run of the arrays.
+    geometry.sphere_bvh.build(sphere_bounds, PackedKernels::padding);
+    geometry.sphere_pack.clear();
+    for (const std::uint32_t index : geometry.sphere_bvh.getPrimitiveIndices())
+    {
+        const SphereRecord& sphere{spheres[sphere_indices[index]]};
+        geometry.sphere_pack.add(getPackedPosition(sphere, positions), sphere.radius, sphere_indices[index]);
+    }
+    geometry.sphere_pack.pad();
+
+    geometry.cuboid_bvh.build(cuboid_bounds, PackedKernels::padding);
+    geometry.cuboid_pack.clear();
+    for (const std::uint32_t index : geometry.cuboid_bvh.getPrimitiveIndices())
+    {
+        const CuboidRecord& cuboid{cuboids[cuboid_indices[index]]};
+        const Vec3 position{getPackedPosition(cuboid, positions)};
+        geometry.cuboid_pack.add(position - cuboid.half_dimensions, position + cuboid.half_dimensions, cuboid_indices[index]);
+    }
+    geometry.cuboid_pack.pad();
+}
+
+void Scene::buildTimeSlices(const std::vector<std::uint32_t>& sphere_indices, const std::vector<std::uint32_t>& cuboid_indices)
+{
+    const auto n_slices{static_cast<size_t>(n_time_slices)};
+    slice_positions.resize(n_slices*dynamics.size());
+    time_slices.resize(n_slices);
+    for (size_t slice{0}; slice < n_slices; ++slice)
+    {
+        const Real time{getSliceTime(slice)};
+        Vec3* positions{&slice_positions[slice*dynamics.size()]};
+        for (size_t i{0}; i < dynamics.size(); ++i)
+        {
+            positions[i] = getPosition(Vec3{}, static_cast<DynamicsIndex>(i), time);
+        }
+        buildPacked(time_slices[slice], sphere_indices, cuboid_indices, positions);
+    }
+}
+
+size_t Scene::getTimeSlice(const Real time) const
+{
+    const auto slice{static_cast<size_t>(std::max<Real>((time - interval.min)/interval.size()*static_cast<Real>(time_slices.size()), 0))};
+    return std::min(slice, time_slices.size() - 1);
+}
+
+Real Scene::getSliceTime(const size_t slice) const
+{
+    // The middle of each slice, so that rounding never moves a time into its neighbour.
+    return interval.min + (static_cast<Real>(slice) + Real{0.5})*interval.size()/static_cast<Real>(time_slices.size());
+}
+
+void Scene::setTimeSlices(const int n_slices)
+{
+    n_time_slices = std::max(n_slices, 0);
+}
+
 void Scene::setTimeInterval(const Interval& new_interval)
 {
     interval = new_interval;
+    build();
 }
 
-void Scene::sample()
+Real Scene::sampleTime(Random::Generator& generator) const
 {
-    const double time{Random::getRandom(interval)};
-    for (const std::unique_ptr<HittableEntity>& entity: entities)
+    // A static scene looks the same at every instant, so there is nothing to draw.
+    if (!has_motion)
     {
-        entity->at(time);
+        return interval.min;
     }
-}
\ No newline at end of file
+    return getTime(generator.getRandom());
+}
+
+Real Scene::sampleTime(Sampler& sampler) const
+{
+    if (!has_motion)
+    {
+        return interval.min;
+    }
+    return getTime(sampler.getTimeSample());
+}
+
+Real Scene::getTime(const Real u) const
+{
+    if (!time_slices.empty())
+    {
+        const auto n_slices{static_cast<Real>(time_slices.size())};
+        return getSliceTime(std::min(static_cast<size_t>(u*n_slices), time_slices.size() - 1));
+    }
+    return interval.min + (interval.max - interval.min)*u;
+}
@@ -0,0 +1,657 @@
+#include "SceneFile.h"
+#include "Ray.h"
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace
+{
+    constexpr std::array<char, 4> magic{'R', 'T', 'S', 'C'};
+    constexpr std::uint32_t version{1};
+    // Sections start on cache-line boundaries, which also satisfies every record's alignment.
+    constexpr std::uint64_t section_alignment{64};
+
+    static_assert(std::is_trivially_copyable_v<CameraConfig>, "The cache stores the camera configuration as it lies in memory");
+    static_assert(std::is_trivially_copyable_v<SphereRecord> && std::is_trivially_copyable_v<CuboidRecord>, "The cache stores records as they lie in memory");
+
+    // Describes the build that wrote the cache as well as the scene, so that a cache is only ever
+    // mapped by a build that lays records out the same way.
+    struct Header
+    {
+        std::array<char, 4> magic{};
+        std::uint32_t version{};
+        std::uint32_t real_size{};
+        std::uint32_t config_size{};
+        std::uint32_t sphere_size{};
+        std::uint32_t cuboid_size{};
+        CameraConfig config{};
+        Vec3 origin{};
+        Vec3 direction{};
+        double twist{};
+        double refractive_index{};
+        std::uint64_t n_materials{};
+        std::uint64_t n_dynamics{};
+        std::uint64_t n_spheres{};
+        std::uint64_t n_cuboids{};
+        std::uint64_t materials_offset{};
+        std::uint64_t dynamics_offset{};
+        std::uint64_t spheres_offset{};
+        std::uint64_t cuboids_offset{};
+    };
+
+    struct StoredMaterial
+    {
+        // The index of the alternative in Material.
+        std::uint32_t type{};
+        Vec3 albedo{};
+        Real parameter{};
+    };
+
+    struct StoredNewtonian
+    {
+        Vec3 position{};
+        Vec3 velocity{};
+        Vec3 acceleration{};
+    };
+
+    std::uint64_t alignSection(const std::uint64_t offset)
+    {
+        return (offset + section_alignment - 1)/section_alignment*section_alignment;
+    }
+
+    StoredMaterial storeMaterial(const Material& material)
+    {
+        return std::visit([&material](const auto& parameters)
+        {
+            using Parameters = std::decay_t<decltype(parameters)>;
+            StoredMaterial stored{static_cast<std::uint32_t>(material.index()), parameters.albedo, 0};
+            if constexpr (std::is_same_v<Parameters, Reflector>)
+            {
+                stored.parameter = parameters.fuzz;
+            }
+            else if constexpr (std::is_same_v<Parameters, Refractor>)
+            {
+                stored.parameter = parameters.refractive_index;
+            }
+            return stored;
+        }, material);
+    }
+
+    // Empty if the type is not one this build knows.
+    std::optional<Material> loadMaterial(const StoredMaterial& stored)
+    {
+        switch (stored.type)
+        {
+            case 0:
+                return Lambertian{stored.albedo};
+            case 1:
+                return Reflector{stored.albedo, stored.parameter};
+            case 2:
+                return Refractor{stored.albedo, stored.parameter};
+            default:
+                return std::nullopt;
+        }
+    }
+
+    // A negative radius would turn a sphere's normals inward, and a negative extent would turn a
+    // cuboid's slabs inside out. Comparisons are written so that NaN fails them.
+    bool hasSize(const SphereRecord& sphere)
+    {
+        return sphere.radius > 0;
+    }
+
+    bool hasSize(const CuboidRecord& cuboid)
+    {
+        return cuboid.half_dimensions[0] > 0 && cuboid.half_dimensions[1] > 0 && cuboid.half_dimensions[2] > 0;
+    }
+
+    // Whether the bytes of a stored enum hold one of its first n_values enumerators.
+    template <typename Enum>
+    bool isEnumValid(const char* bytes, const std::underlying_type_t<Enum> n_values)
+    {
+        std::underlying_type_t<Enum> value{};
+        std::memcpy(&value, bytes, sizeof(value));
+        return value >= 0 && value < n_values;
+    }
+
+    // Checks the bytes behind the stored configuration's enums and bools, which could not be
+    // inspected once copied into them, before the configuration is trusted.
+    bool isConfigStorageValid(const char* config)
+    {
+        for (const size_t offset : {offsetof(CameraConfig, russian_roulette), offsetof(CameraConfig, adaptive_sampling), offsetof(CameraConfig, write_sample_map),
+                                    offsetof(CameraConfig, denoise), offsetof(CameraConfig, write_feature_buffers), offsetof(CameraConfig, progressive)})
+        {
+            if (static_cast<unsigned char>(config[offset]) > 1)
+            {
+                return false;
+            }
+        }
+        return isEnumValid<SamplerType>(config + offsetof(CameraConfig, sampler), static_cast<int>(SamplerType::blue_noise) + 1)
+            && isEnumValid<ImageFormat>(config + offsetof(CameraConfig, image_format), static_cast<int>(ImageFormat::pfm) + 1);
+    }
+
+    // Why the configuration cannot be rendered, or empty if it can. Comparisons are written so
+    // that NaN fails them.
+    std::string getInvalidCameraSetting(const CameraConfig& config)
+    {
+        if (!(config.aspect_ratio > 0))
+        {
+            return "aspect_ratio must be positive";
+        }
+        if (config.image_width <= 0)
+        {
+            return "image_width must be positive";
+        }
+        if (!(config.framerate > 0))
+        {
+            return "framerate must be positive";
+        }
+        if (config.tile_size <= 0)
+        {
+            return "tile_size must be positive";
+        }
+        if (config.preview_scale <= 0)
+        {
+            return "preview_scale must be positive";
+        }
+        if (config.anti_aliasing_samples < 0 || config.min_samples < 0 || config.max_samples < 0)
+        {
+            return "sample counts must not be negative";
+        }
+        if (config.max_depth < 0)
+        {
+            return "max_depth must not be negative";
+        }
+        // A path enters at most one medium per bounce, so this keeps every medium it enters in the
+        // ray's refraction log.
+        if (config.max_depth >= static_cast<int>(Ray::max_nested_media))
+        {
+            return "max_depth must be less than " + std::to_string(Ray::max_nested_media);
+        }
+        if (config.denoise_iterations < 0)
+        {
+            return "denoise_iterations must not be negative";
+        }
+        return {};
+    }
+
+    // Parses the text form a line at a time, keeping the names given to materials.
+    class TextReader
+    {
+    public:
+        TextReader(const std::string& filepath, SceneDescription& description)
+            : filepath{filepath}, description{description}
+        {}
+
+        bool read()
+        {
+            std::ifstream file{filepath};
+            if (!file)
+            {
+                std::clog << "Could not open scene file " << filepath << ".\n";
+                return false;
+            }
+            std::string line{};
+            while (std::getline(file, line))
+            {
+                ++line_number;
+                const size_t comment{line.find('#')};
+                std::istringstream statement{line.substr(0, comment)};
+                std::string keyword{};
+                if (!(statement >> keyword))
+                {
+                    continue;
+                }
+                if (!readStatement(keyword, statement))
+                {
+                    return false;
+                }
+                std::string extra{};
+                if (statement >> extra)
+                {
+                    return fail("unexpected \"" + extra + "\"");
+                }
+            }
+            if (look_at)
+            {
+                description.direction = *look_at - description.origin;
+            }
+            return true;
+        }
+
+    private:
+        bool readStatement(const std::string& keyword, std::istringstream& statement)
+        {
+            if (keyword == "camera")
+            {
+                return readCamera(statement);
+            }
+            if (keyword == "refractive_index")
+            {
+                double refractive_index{};
+                if (!(statement >> refractive_index))
+                {
+                    return fail("expected a refractive index");
+                }
+                if (description.scene.size() > 0 || !description.scene.getMaterials().empty())
+                {
+                    return fail("refractive_index must come before any material or primitive");
+                }
+                description.scene = Scene{refractive_index};
+                return true;
+            }
+            if (keyword == "material")
+            {
+                return readMaterial(statement);
+            }
+            if (keyword == "sphere")
+            {
+                SphereRecord sphere{};
+                if (!readVec3(statement, sphere.centre) || !(statement >> sphere.radius))
+                {
+                    return fail("expected a centre and radius");
+                }
+                if (!hasSize(sphere))
+                {
+                    return fail("sphere radius must be positive");
+                }
+                if (!readPrimitiveTail(statement, sphere.centre, sphere.material, sphere.dynamics))
+                {
+                    return false;
+                }
+                description.scene.addRecord(sphere);
+                return true;
+            }
+            if (keyword == "cuboid")
+            {
+                CuboidRecord cuboid{};
+                Vec3 dimensions{};
+                if (!readVec3(statement, cuboid.centre) || !readVec3(statement, dimensions))
+                {
+                    return fail("expected a centre and dimensions");
+                }
+                cuboid.half_dimensions = 0.5*dimensions;
+                if (!hasSize(cuboid))
+                {
+                    return fail("cuboid dimensions must be positive");
+                }
+                if (!readPrimitiveTail(statement, cuboid.centre, cuboid.material, cuboid.dynamics))
+                {
+                    return false;
+                }
+                description.scene.addRecord(cuboid);
+                return true;
+            }
+            return fail("unknown statement \"" + keyword + "\"");
+        }
+
+        bool readCamera(std::istringstream& statement)
+        {
+            std::string field{};
+            statement >> field;
+            if (field == "origin")
+            {
+                return readVec3(statement, description.origin) || fail("expected a camera origin");
+            }
+            if (field == "look_at")
+            {
+                return readVec3(statement, look_at.emplace()) || fail("expected a point to look at");
+            }
+            if (field == "image_format")
+            {
+                return readImageFormat(statement, description.config.image_format) || fail("expected ascii_ppm, binary_ppm or pfm");
+            }
+            if (field == "sampler")
+            {
+                std::string name{};
+                statement >> name;
+                return Sampler::parse(name, description.config.sampler) || fail("expected independent, stratified, sobol or blue_noise");
+            }
+            bool matched{false};
+            bool valid{false};
+            const auto read_field{[&](const char* name, auto& value)
+            {
+                if (!matched && field == name)
+                {
+                    matched = true;
+                    valid = static_cast<bool>(statement >> std::boolalpha >> value);
+                }
+            }};
+            CameraConfig& config{description.config};
+            read_field("twist", description.twist);
+            read_field("aspect_ratio", config.aspect_ratio);
+            read_field("image_width", config.image_width);
+            read_field("focus_distance", config.focus_distance);
+            read_field("field_of_view", config.field_of_view);
+            read_field("defocus_angle", config.defocus_angle);
+            read_field("framerate", config.framerate);
+            read_field("anti_aliasing_samples", config.anti_aliasing_samples);
+            read_field("max_depth", config.max_depth);
+            read_field("russian_roulette", config.russian_roulette);
+            read_field("roulette_min_depth", config.roulette_min_depth);
+            read_field("seed", config.seed);
+            read_field("threads", config.threads);
+            read_field("tile_size", config.tile_size);
+            read_field("adaptive_sampling", config.adaptive_sampling);
+            read_field("min_samples", config.min_samples);
+            read_field("max_samples", config.max_samples);
+            read_field("noise_threshold", config.noise_threshold);
+            read_field("write_sample_map", config.write_sample_map);
+            read_field("denoise", config.denoise);
+            read_field("denoise_iterations", config.denoise_iterations);
+            read_field("write_feature_buffers", config.write_feature_buffers);
+            read_field("progressive", config.progressive);
+            read_field("time_budget", config.time_budget);
+            read_field("target_noise", config.target_noise);
+            read_field("preview_scale", config.preview_scale);
+            if (!matched)
+            {
+                return fail("unknown camera setting \"" + field + "\"");
+            }
+            if (!valid)
+            {
+                return fail("bad value for camera " + field);
+            }
+            const std::string invalid{getInvalidCameraSetting(config)};
+            return invalid.empty() || fail("camera " + invalid);
+        }
+
+        static bool readImageFormat(std::istringstream& statement, ImageFormat& format)
+        {
+            std::string name{};
+            statement >> name;
+            for (const ImageFormat candidate : {ImageFormat::ascii_ppm, ImageFormat::binary_ppm, ImageFormat::pfm})
+            {
+                if (name == getFormatName(candidate))
+                {
+                    format = candidate;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static const char* getFormatName(const ImageFormat format)
+        {
+            switch (format)
+            {
+                case ImageFormat::ascii_ppm:
+                    return "ascii_ppm";
+                case ImageFormat::binary_ppm:
+                    return "binary_ppm";
+                default:
+                    return "pfm";
+            }
+        }
+
+        bool readMaterial(std::istringstream& statement)
+        {
+            std::string name{};
+            std::string type{};
+            Vec3 albedo{};
+            if (!(statement >> name >> type) || !readVec3(statement, albedo))
+            {
+                return fail("expected a material name, type and albedo");
+            }
+            std::optional<Material> material{};
+            double parameter{};
+            if (type == "lambertian")
+            {
+                material = Lambertian{albedo};
+            }
+            else if (type != "reflector" && type != "refractor")
+            {
+                return fail("unknown material type \"" + type + "\"");
+            }
+            else if (!(statement >> parameter))
+            {
+                return fail("expected a " + std::string{type == "reflector" ? "fuzz" : "refractive index"} + " for material \"" + name + "\"");
+            }
+            else if (type == "reflector")
+            {
+                material = Reflector{albedo, parameter};
+            }
+            else
+            {
+                material = Refractor{albedo, parameter};
+            }
+            material_indices[name] = description.scene.addMaterial(*material);
+            return true;
+        }
+
+        // Reads the material name and any dynamics that end every primitive.
+        bool readPrimitiveTail(std::istringstream& statement, const Vec3& centre, Materials::Index& material, DynamicsIndex& dynamics)
+        {
+            std::string name{};
+            if (!(statement >> name))
+            {
+                return fail("expected a material");
+            }
+            const auto found{material_indices.find(name)};
+            if (found == material_indices.end())
+            {
+                return fail("undeclared material \"" + name + "\"");
+            }
+            material = found->second;
+            std::string motion{};
+            if (!(statement >> motion))
+            {
+                return true;
+            }
+            Vec3 velocity{};
+            Vec3 acceleration{};
+            if (motion != "newtonian" || !readVec3(statement, velocity) || !readVec3(statement, acceleration))
+            {
+                return fail("expected newtonian and a velocity and acceleration");
+            }
+            dynamics = description.scene.addDynamics(Newtonian{centre, velocity, acceleration});
+            return true;
+        }
+
+        static bool readVec3(std::istringstream& statement, Vec3& vec)
+        {
+            return static_cast<bool>(statement >> vec[0] >> vec[1] >> vec[2]);
+        }
+
+        bool fail(const std::string& message) const
+        {
+            std::clog << filepath << ":" << line_number << ": " << message << ".\n";
+            return false;
+        }
+
+        const std::string& filepath;
+        SceneDescription& description;
+        std::unordered_map<std::string, Materials::Index> material_indices{};
+        std::optional<Vec3> look_at{};
+        int line_number{0};
+    };
+
+    // Unmaps a cache once the last scene using its records lets go.
+    std::shared_ptr<const void> mapFile(const std::string& filepath, size_t& size)
+    {
+        const int descriptor{open(filepath.c_str(), O_RDONLY)};
+        if (descriptor < 0)
+        {
+            return nullptr;
+        }
+        struct stat status{};
+        void* address{MAP_FAILED};
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            size = static_cast<size_t>(status.st_size);
+            address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        }
+        close(descriptor);
+        if (address == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        return {address, [size](const void* mapped)
+        {
+            munmap(const_cast<void*>(mapped), size);
+        }};
+    }
+
+    template <typename T>
+    bool isSectionValid(const std::uint64_t offset, const std::uint64_t count, const size_t file_size)
+    {
+        return offset % alignof(T) == 0 && offset <= file_size && count <= (file_size - offset)/sizeof(T);
+    }
+
+    template <typename Record>
+    bool areRecordsValid(const std::span<const Record> records, const size_t n_materials, const size_t n_dynamics)
+    {
+        for (const Record& record : records)
+        {
+            if (!hasSize(record) || record.material >= n_materials || (record.dynamics != no_dynamics && record.dynamics >= n_dynamics))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool SceneFile::load(const std::string& filepath, SceneDescription& description)
+{
+    std::array<char, 4> file_magic{};
+    std::ifstream{filepath, std::ios::binary}.read(file_magic.data(), file_magic.size());
+    return file_magic == magic ? readCache(filepath, description) : readText(filepath, description);
+}
+
+bool SceneFile::readText(const std::string& filepath, SceneDescription& description)
+{
+    return TextReader{filepath, description}.read();
+}
+
+bool SceneFile::writeCache(const std::string& filepath, const SceneDescription& description)
+{
+    const Scene& scene{description.scene};
+    if (!scene.getHittableEntities().empty())
+    {
+        std::clog << "Scene caches only hold spheres and cuboids.\n";
+        return false;
+    }
+    std::vector<StoredNewtonian> dynamics{};
+    for (const std::optional<Newtonian>& newtonian : scene.getNewtonianDynamics())
+    {
+        if (!newtonian)
+        {
+            std::clog << "Scene caches only hold Newtonian dynamics.\n";
+            return false;
+        }
+        dynamics.push_back({newtonian->getPosition(), newtonian->getVelocity(), newtonian->getAcceleration()});
+    }
+    std::vector<StoredMaterial> materials{};
+    for (const Material& material : scene.getMaterials())
+    {
+        materials.push_back(storeMaterial(material));
+    }
+
+    Header header{magic, version, sizeof(Real), sizeof(CameraConfig), sizeof(SphereRecord), sizeof(CuboidRecord),
+        description.config, description.origin, description.direction, description.twist, scene.getRefractiveIndex(),
+        materials.size(), dynamics.size(), scene.getSpheres().size(), scene.getCuboids().size()};
+    header.materials_offset = alignSection(sizeof(Header));
+    header.dynamics_offset = alignSection(header.materials_offset + materials.size()*sizeof(StoredMaterial));
+    header.spheres_offset = alignSection(header.dynamics_offset + dynamics.size()*sizeof(StoredNewtonian));
+    header.cuboids_offset = alignSection(header.spheres_offset + scene.getSpheres().size()*sizeof(SphereRecord));
+
+    std::ofstream file{filepath, std::ios::binary};
+    const auto write_section{[&file](const std::uint64_t offset, const void* data, const size_t n_bytes)
+    {
+        const auto padding{static_cast<size_t>(offset) - static_cast<size_t>(file.tellp())};
+        file.write(std::string(padding, '\0').data(), static_cast<std::streamsize>(padding));
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(n_bytes));
+    }};
+    write_section(0, &header, sizeof(Header));
+    write_section(header.materials_offset, materials.data(), materials.size()*sizeof(StoredMaterial));
+    write_section(header.dynamics_offset, dynamics.data(), dynamics.size()*sizeof(StoredNewtonian));
+    write_section(header.spheres_offset, scene.getSpheres().data(), scene.getSpheres().size_bytes());
+    write_section(header.cuboids_offset, scene.getCuboids().data(), scene.getCuboids().size_bytes());
+    return static_cast<bool>(file);
+}
+
+bool SceneFile::readCache(const std::string& filepath, SceneDescription& description)
+{
+    size_t size{0};
+    const std::shared_ptr<const void> mapping{mapFile(filepath, size)};
+    if (!mapping || size < sizeof(Header))
+    {
+        std::clog << "Could not map scene cache " << filepath << ".\n";
+        return false;
+    }
+    const auto* bytes{static_cast<const char*>(mapping.get())};
+    Header header{};
+    std::memcpy(&header, bytes, sizeof(Header));
+    if (header.magic != magic || header.version != version || header.real_size != sizeof(Real) || header.config_size != sizeof(CameraConfig)
+        || header.sphere_size != sizeof(SphereRecord) || header.cuboid_size != sizeof(CuboidRecord))
+    {
+        std::clog << "Scene cache " << filepath << " was written by an incompatible build.\n";
+        return false;
+    }
+    if (!isSectionValid<StoredMaterial>(header.materials_offset, header.n_materials, size)
+        || !isSectionValid<StoredNewtonian>(header.dynamics_offset, header.n_dynamics, size)
+        || !isSectionValid<SphereRecord>(header.spheres_offset, header.n_spheres, size)
+        || !isSectionValid<CuboidRecord>(header.cuboids_offset, header.n_cuboids, size))
+    {
+        std::clog << "Scene cache " << filepath << " is truncated.\n";
+        return false;
+    }
+
+    if (!isConfigStorageValid(bytes + offsetof(Header, config)))
+    {
+        std::clog << "Scene cache " << filepath << " has a camera setting that is not a valid choice.\n";
+        return false;
+    }
+    if (const std::string invalid{getInvalidCameraSetting(header.config)}; !invalid.empty())
+    {
+        std::clog << "Scene cache " << filepath << " has an invalid camera: " << invalid << ".\n";
+        return false;
+    }
+
+    description.config = header.config;
+    description.origin = header.origin;
+    description.direction = header.direction;
+    description.twist = header.twist;
+    description.scene = Scene{header.refractive_index};
+    const auto* materials{reinterpret_cast<const StoredMaterial*>(bytes + header.materials_offset)};
+    for (size_t i{0}; i < header.n_materials; ++i)
+    {
+        const std::optional<Material> material{loadMaterial(materials[i])};
+        if (!material)
+        {
+            std::clog << "Scene cache " << filepath << " holds a material of unknown type " << materials[i].type << ".\n";
+            return false;
+        }
+        description.scene.addMaterial(*material);
+    }
+    const auto* dynamics{reinterpret_cast<const StoredNewtonian*>(bytes + header.dynamics_offset)};
+    for (size_t i{0}; i < header.n_dynamics; ++i)
+    {
+        description.scene.addDynamics(Newtonian{dynamics[i].position, dynamics[i].velocity, dynamics[i].acceleration});
+    }
+
+    // The records are used where they lie; checking their sizes and indices is the only pass over them.
+    const std::span<const SphereRecord> spheres{reinterpret_cast<const SphereRecord*>(bytes + header.spheres_offset), header.n_spheres};
+    const std::span<const CuboidRecord> cuboids{reinterpret_cast<const CuboidRecord*>(bytes + header.cuboids_offset), header.n_cuboids};
+    const size_t n_materials{description.scene.getMaterials().size()};
+    const size_t n_dynamics{description.scene.getDynamicsCount()};
+    if (n_materials != header.n_materials || !areRecordsValid(spheres, n_materials, n_dynamics) || !areRecordsValid(cuboids, n_materials, n_dynamics))
+    {
+        std::clog << "Scene cache " << filepath << " holds primitives with no size, or refers to materials or dynamics it does not hold.\n";
+        return false;
+    }
+    description.scene.borrowRecords(spheres, cuboids, mapping);
+    return true;
+}
@@ -1,28 +1,35 @@
 #include "Sphere.h"
+#include <algorithm>
 #include <cmath>
 
 Hit Sphere::getRayHit(const Ray& ray, const Interval& interval) const
+{
+    return getRayHit(getPosition(ray.getTime()), radius, getMaterialIndex(), ray, interval);
+}
+
+Hit Sphere::getRayHit(const Vec3& position, const Real radius, const Materials::Index material, const Ray& ray, const Interval& interval)
 {
     const Vec3 origin_to_origin {position - ray.getOrigin()};
-    const double a{ray.getDirection().lengthSquared()};
-    const double h{ray.getDirection().dot(origin_to_origin)};
-    const double c{origin_to_origin.lengthSquared() - radius * radius};
-    const double discriminant{h*h - a*c};
-    const double first_part{h/a};
-    const double second_part{std::sqrt(discriminant)/a};
-    if (discriminant < 0)
+    const Real a{ray.getLengthSquared()};
+    const Real h{ray.getDirection().dot(origin_to_origin)};
+    const Real c{origin_to_origin.lengthSquared() - radius * radius};
+    const Real discriminant{h*h - a*c};
+    const Real first_part{h/a};
+    // Clamping keeps the square root inline: a negative argument would call into libm to set errno.
+    const Real second_part{std::sqrt(std::max(discriminant, Real{0}))/a};
+    // Both roots are found before deciding, so the choice between them compiles to a select.
+    const Real near_root{first_part - second_part};
+    const Real far_root{first_part + second_part};
+    const Real root{interval.contains(near_root) ? near_root : far_root};
+    if (discriminant < 0 || !interval.contains(root))
     {
         return Hit();
     }
-    double root {first_part - second_part};
-    if (!interval.contains(root))
-    {
-        root = first_part + second_part;
-        if (!interval.contains(root))
-        {
-            return Hit();
-        }
-    }
     Vec3 point{ray.at(root)};
-    return Hit{root, point, (point - position)/radius, getMaterial()};
+    return Hit{root, point, (point - position)/radius, material};
+}
+
+AABB Sphere::getBoundingBox(const Interval& time) const
+{
+    return getDynamics().sweep(time).pad(Vec3{radius, radius, radius});
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "TileScheduler.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Tiles are taken from the front by the queue's own thread and stolen from the back by others.
+    // Every tile is queued before any is taken, into room reserved up front, so the queue
+    // allocates once however many tiles it holds.
+    class TileQueue
+    {
+    public:
+        void reserve(const size_t n_tiles)
+        {
+            tiles.reserve(n_tiles);
+        }
+
+        void push(const Tile& tile)
+        {
+            const std::lock_guard lock{mutex};
+            tiles.push_back(tile);
+        }
+
+        bool pop(Tile& tile)
+        {
+            const std::lock_guard lock{mutex};
+            if (front == tiles.size())
+            {
+                return false;
+            }
+            tile = tiles[front++];
+            return true;
+        }
+
+        bool steal(Tile& tile)
+        {
+            const std::lock_guard lock{mutex};
+            if (front == tiles.size())
+            {
+                return false;
+            }
+            tile = tiles.back();
+            tiles.pop_back();
+            return true;
+        }
+
+    private:
+        std::mutex mutex{};
+        std::vector<Tile> tiles{};
+        size_t front{0};
+    };
+
+    // Written in one call so concurrent reports do not interleave, from a buffer on the stack so
+    // reporting allocates nothing.
+    void reportRemaining(const int remaining)
+    {
+        constexpr std::string_view prefix{"Rendering tiles. Remaining: "};
+        std::array<char, prefix.size() + 16> message{};
+        char* end{std::copy(prefix.begin(), prefix.end(), message.data())};
+        end = std::to_chars(end, message.data() + message.size() - 1, remaining).ptr;
+        *end++ = '\n';
+        std::clog.write(message.data(), end - message.data());
+    }
+}
+
+TileScheduler::TileScheduler(const int width, const int height, const int tile_size, const int n_threads, const bool report_progress)
+    : width{width},
+      height{height},
+      tile_size{std::max(tile_size, 1)},
+      n_tiles_x{(width + this->tile_size - 1)/this->tile_size},
+      n_tiles_y{(height + this->tile_size - 1)/this->tile_size},
+      n_threads{std::min(resolveThreadCount(n_threads), std::max(n_tiles_x*n_tiles_y, 1))},
+      report_progress{report_progress}
+{
+}
+
+int TileScheduler::resolveThreadCount(const int requested)
+{
+    if (requested > 0)
+    {
+        return requested;
+    }
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+Tile TileScheduler::getTile(const int index) const
+{
+    const int x_min{(index % n_tiles_x)*tile_size};
+    const int y_min{(index / n_tiles_x)*tile_size};
+    return Tile{x_min, y_min, std::min(x_min + tile_size, width), std::min(y_min + tile_size, height)};
+}
+
+void TileScheduler::run(const std::function<void(const Tile&)>& render_tile, const int first_tile, const int last_tile) const
+{
+    const int end_tile{last_tile < 0 ? getTileCount() : std::min(last_tile, getTileCount())};
+    const int begin_tile{std::clamp(first_tile, 0, end_tile)};
+    const int n_tiles{end_tile - begin_tile};
+    const auto n_queues{static_cast<size_t>(n_threads)};
+    std::vector<TileQueue> queues(n_queues);
+    for (TileQueue& queue : queues)
+    {
+        queue.reserve(static_cast<size_t>(n_tiles)/n_queues + 1);
+    }
+    for (int i{0}; i < n_tiles; ++i)
+    {
+        queues[static_cast<size_t>(i)*n_queues/static_cast<size_t>(n_tiles)].push(getTile(begin_tile + i));
+    }
+
+    std::atomic<int> n_remaining{n_tiles};
+    const int report_interval{std::max(n_tiles/100, 1)};
+    if (report_progress)
+    {
+        reportRemaining(n_tiles);
+    }
+
+    const auto work{[&](const size_t id)
+    {
+        Tile tile{};
+        while (true)
+        {
+            bool found{queues[id].pop(tile)};
+            for (size_t offset{1}; !found && offset < n_queues; ++offset)
+            {
+                found = queues[(id + offset) % n_queues].steal(tile);
+            }
+            // No tiles are queued after start-up, so once every queue is empty this thread is done.
+            if (!found)
+            {
+                return;
+            }
+            render_tile(tile);
+            const int remaining{n_remaining.fetch_sub(1, std::memory_order_relaxed) - 1};
+            if (report_progress && remaining % report_interval == 0)
+            {
+                reportRemaining(remaining);
+            }
+        }
+    }};
+
+    std::vector<std::jthread> workers{};
+    workers.reserve(n_queues - 1);
+    for (size_t id{1}; id < n_queues; ++id)
+    {
+        workers.emplace_back(work, id);
+    }
+    work(0);
+}
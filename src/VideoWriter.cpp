@@ -0,0 +1,142 @@
+#include "VideoWriter.h"
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // BT.601 luma and chroma weights, scaled to the limited 16-235 and 16-240 ranges.
+    std::uint8_t getLuma(const double r, const double g, const double b)
+    {
+        return static_cast<std::uint8_t>(std::lround(16 + 65.481*r + 128.553*g + 24.966*b));
+    }
+
+    std::uint8_t getBlueDifference(const double r, const double g, const double b)
+    {
+        return static_cast<std::uint8_t>(std::lround(128 - 37.797*r - 74.203*g + 112.0*b));
+    }
+
+    std::uint8_t getRedDifference(const double r, const double g, const double b)
+    {
+        return static_cast<std::uint8_t>(std::lround(128 + 112.0*r - 93.786*g - 18.214*b));
+    }
+}
+
+Y4MWriter::Y4MWriter(const std::string& filepath, const int width, const int height, const double framerate, const size_t queue_capacity)
+    : width{width}, height{height}, queue_capacity{std::max<size_t>(queue_capacity, 1)}
+{
+    if (filepath == "-")
+    {
+        stream = &std::cout;
+    }
+    else
+    {
+        file.open(filepath, std::ios::binary);
+        stream = &file;
+    }
+    const std::string header{getHeader(width, height, framerate)};
+    stream->write(header.data(), static_cast<std::streamsize>(header.size()));
+    writer = std::jthread{[this]{writeFrames();}};
+}
+
+Y4MWriter::~Y4MWriter()
+{
+    {
+        const std::lock_guard lock{mutex};
+        finished = true;
+    }
+    frame_added.notify_one();
+    writer.join();
+    stream->flush();
+}
+
+void Y4MWriter::add(std::vector<Vec3> frame)
+{
+    {
+        std::unique_lock lock{mutex};
+        frame_taken.wait(lock, [this]{return frames.size() < queue_capacity;});
+        frames.push_back(std::move(frame));
+    }
+    frame_added.notify_one();
+}
+
+void Y4MWriter::writeFrames()
+{
+    std::string buffer{};
+    while (true)
+    {
+        std::vector<Vec3> frame{};
+        {
+            std::unique_lock lock{mutex};
+            frame_added.wait(lock, [this]{return finished || !frames.empty();});
+            if (frames.empty())
+            {
+                return;
+            }
+            frame = std::move(frames.front());
+            frames.pop_front();
+        }
+        frame_taken.notify_one();
+        buffer.clear();
+        encode(frame, width, height, buffer);
+        stream->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+}
+
+std::string Y4MWriter::getHeader(const int width, const int height, const double framerate)
+{
+    // Frame rates are rational; a whole number of thousandths covers the usual 23.976 and 29.97.
+    const auto rate{std::llround(framerate*1000)};
+    const bool whole{rate % 1000 == 0};
+    const std::string numerator{std::to_string(whole ? rate/1000 : rate)};
+    const std::string denominator{whole ? "1" : "1000"};
+    return "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) + " F" + numerator + ":" + denominator
+        + " Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+}
+
+void Y4MWriter::encode(const std::vector<Vec3>& pixels, const int width, const int height, std::string& buffer)
+{
+    const auto n_pixels{static_cast<size_t>(width*height)};
+    std::vector<std::uint8_t> rgb(3*n_pixels);
+    ImageWriter::quantise(pixels, rgb.data());
+    const auto channel{[&rgb, width](const int i, const int j, const int c)
+    {
+        return rgb[3*static_cast<size_t>(i + j*width) + static_cast<size_t>(c)]/255.0;
+    }};
+
+    // Chroma is averaged over each 2x2 block, clamped at the edges of odd-sized frames.
+    const int chroma_width{(width + 1)/2};
+    const int chroma_height{(height + 1)/2};
+    const auto n_chroma{static_cast<size_t>(chroma_width*chroma_height)};
+    buffer += "FRAME\n";
+    const size_t luma_start{buffer.size()};
+    const size_t blue_start{luma_start + n_pixels};
+    const size_t red_start{blue_start + n_chroma};
+    buffer.resize(red_start + n_chroma);
+    for (int j{0}; j < height; ++j)
+    {
+        for (int i{0}; i < width; ++i)
+        {
+            buffer[luma_start + static_cast<size_t>(i + j*width)] = static_cast<char>(getLuma(channel(i, j, 0), channel(i, j, 1), channel(i, j, 2)));
+        }
+    }
+    for (int j{0}; j < chroma_height; ++j)
+    {
+        for (int i{0}; i < chroma_width; ++i)
+        {
+            const int left{2*i};
+            const int right{std::min(2*i + 1, width - 1)};
+            const int top{2*j};
+            const int bottom{std::min(2*j + 1, height - 1)};
+            double mean[3]{};
+            for (int c{0}; c < 3; ++c)
+            {
+                mean[c] = (channel(left, top, c) + channel(right, top, c) + channel(left, bottom, c) + channel(right, bottom, c))/4;
+            }
+            const auto index{static_cast<size_t>(i + j*chroma_width)};
+            buffer[blue_start + index] = static_cast<char>(getBlueDifference(mean[0], mean[1], mean[2]));
+            buffer[red_start + index] = static_cast<char>(getRedDifference(mean[0], mean[1], mean[2]));
+        }
+    }
+}
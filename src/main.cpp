@@ -3,12 +3,162 @@
 #include "Camera.h"
 #include "Vec3.h"
 #include "Scene.h"
+#include "SceneFile.h"
 #include "Utilities.h"
+#include <charconv>
+#include <iostream>
+#include <optional>
+#include <string>
 
-int main()
+namespace
 {
+    // Parses "FIRST:LAST", where an empty LAST runs to the end.
+    bool parseRange(const std::string& text, int& first, int& last)
+    {
+        const size_t colon{text.find(':')};
+        if (colon == std::string::npos)
+        {
+            return false;
+        }
+        const char* begin{text.data()};
+        const char* end{text.data() + text.size()};
+        if (std::from_chars(begin, begin + colon, first).ec != std::errc{})
+        {
+            return false;
+        }
+        last = -1;
+        return colon + 1 == text.size() || std::from_chars(begin + colon + 1, end, last).ec == std::errc{};
+    }
+
+    // Parses a whole argument as a number of seconds, which must not be negative.
+    bool parseSeconds(const std::string& text, double& seconds)
+    {
+        const char* end{text.data() + text.size()};
+        const auto [parsed_end, error]{std::from_chars(text.data(), end, seconds)};
+        return error == std::errc{} && parsed_end == end && seconds >= 0;
+    }
+}
+
+// Usage: raytracer [--scene PATH [--compile-scene CACHE]] [--tiles FIRST:LAST] [--samples FIRST:LAST] [--checkpoint PATH [--checkpoint-interval SECONDS]] [--sampler NAME] [--denoise] [--feature-buffers] [--progressive SECONDS] [--output PATH]
+// Renders the scene file, text or compiled, or the scene built below if none is given. With
+// --compile-scene, writes the scene as a binary cache for later runs to map instead of parsing.
+// With a tile or sample range, renders only that shard of the image and writes it as a partial
+// framebuffer, to be combined with the other shards by raytracer_merge. With a checkpoint, saves
+// progress there periodically and on SIGTERM, and resumes from it if it already exists, exiting
+// with 1 and rendering nothing if it was saved by a different render. The sampler, one of
+// independent, stratified, sobol or blue_noise, overrides the scene's. --denoise filters the
+// finished image, and --feature-buffers writes the albedo, normal and depth it is guided by beside
+// the image. --progressive renders passes of one sample per pixel for at most the given number of
+// seconds, rewriting the image after each.
+int main(const int argc, char** argv)
+{
+    RenderShard shard{};
+    bool sharded{false};
+    CheckpointConfig checkpoint{};
+    std::string scene_path{};
+    std::string cache_path{};
+    std::optional<SamplerType> sampler{};
+    bool denoise{false};
+    bool write_feature_buffers{false};
+    std::optional<double> time_budget{};
+    std::string output{"/Users/daniel/Documents/GitHub/raytracing/rt2.ppm"};
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string argument{argv[i]};
+        if (argument == "--tiles" && i + 1 < argc && parseRange(argv[i + 1], shard.first_tile, shard.last_tile))
+        {
+            sharded = true;
+            ++i;
+        }
+        else if (argument == "--samples" && i + 1 < argc && parseRange(argv[i + 1], shard.first_sample, shard.last_sample))
+        {
+            sharded = true;
+            ++i;
+        }
+        else if (argument == "--checkpoint" && i + 1 < argc)
+        {
+            checkpoint.filepath = argv[++i];
+        }
+        else if (argument == "--checkpoint-interval" && i + 1 < argc && parseSeconds(argv[i + 1], checkpoint.interval))
+        {
+            ++i;
+        }
+        else if (argument == "--scene" && i + 1 < argc)
+        {
+            scene_path = argv[++i];
+        }
+        else if (argument == "--compile-scene" && i + 1 < argc)
+        {
+            cache_path = argv[++i];
+        }
+        else if (argument == "--sampler" && i + 1 < argc && Sampler::parse(argv[i + 1], sampler.emplace()))
+        {
+            ++i;
+        }
+        else if (argument == "--denoise")
+        {
+            denoise = true;
+        }
+        else if (argument == "--feature-buffers")
+        {
+            write_feature_buffers = true;
+        }
+        else if (argument == "--progressive" && i + 1 < argc && parseSeconds(argv[i + 1], time_budget.emplace()))
+        {
+            ++i;
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            std::clog << "Usage: raytracer [--scene PATH [--compile-scene CACHE]] [--tiles FIRST:LAST] [--samples FIRST:LAST] [--checkpoint PATH [--checkpoint-interval SECONDS]] [--sampler NAME] [--denoise] [--feature-buffers] [--progressive SECONDS] [--output PATH]\n";
+            return 1;
+        }
+    }
+
+    if (!scene_path.empty())
+    {
+        SceneDescription description{};
+        if (!SceneFile::load(scene_path, description))
+        {
+            return 1;
+        }
+        const MaterialReport materials{description.scene.getMaterialReport()};
+        std::clog << "Loaded " << description.scene.size() << " primitives sharing " << materials.n_unique << " materials ("
+                  << materials.library_bytes << " bytes, against " << materials.copied_bytes << " for a copy per primitive).\n";
+        if (!cache_path.empty())
+        {
+            return SceneFile::writeCache(cache_path, description) ? 0 : 1;
+        }
+        description.config.sampler = sampler.value_or(description.config.sampler);
+        description.config.denoise = description.config.denoise || denoise;
+        description.config.write_feature_buffers = description.config.write_feature_buffers || write_feature_buffers;
+        if (time_budget)
+        {
+            description.config.progressive = true;
+            description.config.time_budget = *time_budget;
+        }
+        const Camera camera{description.makeCamera()};
+        if (sharded)
+        {
+            camera.renderShard(description.scene, output, Interval{0.0, 0.0}, shard);
+        }
+        else if (!checkpoint.filepath.empty())
+        {
+            const ResumableRender render{camera.renderResumable(description.scene, output, Interval{0.0, 0.0}, checkpoint)};
+            return render.checkpoint == Checkpoint::Status::mismatched ? 1 : 0;
+        }
+        else
+        {
+            camera.render(description.scene, output, 0.0, true);
+        }
+        return 0;
+    }
+
     constexpr Vec3 camera_origin{13,2,3};
-    constexpr CameraConfig camera_config
+    const CameraConfig camera_config
     {
         .aspect_ratio = 16.0/9.0,
         .image_width = 1920,
@@ -18,6 +168,11 @@ int main()
         .framerate = 2,
         .anti_aliasing_samples = 50,
         .max_depth = 10,
+        .sampler = sampler.value_or(SamplerType::independent),
+        .denoise = denoise,
+        .write_feature_buffers = write_feature_buffers,
+        .progressive = time_budget.has_value(),
+        .time_budget = time_budget.value_or(CameraConfig{}.time_budget),
     };
     Camera camera{camera_config, camera_origin};
     camera.lookAt(Vec3{0,0,0});
@@ -72,7 +227,18 @@ int main()
     scene.add(Cuboid{Vec3{5,0.2,-1}, {0.2,0.2,0.2}, lambertian});
 
     //camera.render(scene, "/Users/daniel/Documents/GitHub/raytracing/test1.ppm", 0.5);  // Render without motion blur
-    camera.render(scene, "/Users/daniel/Documents/GitHub/raytracing/rt2.ppm", 0.0, true);  // Render with motion blur
+    if (sharded)
+    {
+        camera.renderShard(scene, output, Interval{0.0, 0.0}, shard);
+        return 0;
+    }
+    if (!checkpoint.filepath.empty())
+    {
+        const ResumableRender render{camera.renderResumable(scene, output, Interval{0.0, 0.0}, checkpoint)};
+        return render.checkpoint == Checkpoint::Status::mismatched ? 1 : 0;
+    }
+    camera.render(scene, output, 0.0, true);  // Render with motion blur
     //camera.renderAnimation(scene, "/Users/daniel/Documents/GitHub/raytracing/no-motion-blur-2", Interval{0.0, 5.0}, false); // Render a series of frames without motion blur
     //camera.renderAnimation(scene, "/Users/daniel/Documents/GitHub/raytracing/motion-blur-2", Interval{0.0, 5.0}, true); // Render a series of frames with motion blur
+    //camera.renderVideo(scene, "-", Interval{0.0, 5.0}, true); // Stream frames with motion blur to stdout, e.g. raytracer | ffmpeg -i - animation.mp4
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "ImageWriter.h"
+#include "PartialFramebuffer.h"
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+// Usage: raytracer_merge OUTPUT SHARD...
+// Merges the partial framebuffers of a sharded render into one image, written as a PFM if OUTPUT
+// ends in .pfm and as a binary PPM otherwise. Tile shards are stitched together, and pixels that
+// several sample shards traced are averaged, weighted by their sample counts.
+int main(const int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::clog << "Usage: raytracer_merge OUTPUT SHARD...\n";
+        return 1;
+    }
+    PartialFramebuffer merged{};
+    for (int i{2}; i < argc; ++i)
+    {
+        PartialFramebuffer partial{};
+        if (!partial.read(argv[i]))
+        {
+            std::clog << "Could not read shard " << argv[i] << ".\n";
+            return 1;
+        }
+        if (i == 2)
+        {
+            merged = std::move(partial);
+        }
+        else if (!merged.merge(partial))
+        {
+            std::clog << "Shard " << argv[i] << " is a different size from the first.\n";
+            return 1;
+        }
+    }
+
+    size_t n_missing{0};
+    for (const std::uint32_t count : merged.getSampleCounts())
+    {
+        n_missing += count == 0 ? 1 : 0;
+    }
+    if (n_missing > 0)
+    {
+        std::clog << n_missing << " pixels were in no shard and are left black.\n";
+    }
+    const std::string output{argv[1]};
+    const ImageFormat format{std::filesystem::path{output}.extension() == ".pfm" ? ImageFormat::pfm : ImageFormat::binary_ppm};
+    ImageWriter::write(output, merged.getColours(), merged.getWidth(), merged.getHeight(), *ImageWriter::makeEncoder(format));
+    std::clog << "Merged " << argc - 2 << " shards into " << output << ".\n";
+    return 0;
+}